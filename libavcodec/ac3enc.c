@@ -489,52 +489,67 @@ static void encode_exponents_blk_ch(uint8_t *exp, int nb_exps, int exp_strategy,
 
 
 /*
- * Encode exponents from original extracted form to what the decoder will see.
+ * Encode exponents of one channel from original extracted form to what the
+ * decoder will see.
  * This copies and groups exponents based on exponent strategy and reduces
  * deltas between adjacent exponent groups so that they can be differentially
  * encoded.
  */
-static void encode_exponents(AC3EncodeContext *s)
+static int encode_exponents_ch(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
 {
-    int blk, blk1, ch, cpl;
+    AC3EncodeContext *s = avctx->priv_data;
+    int ch  = jobnr + !s->cpl_on;
+    int cpl = (ch == CPL_CH);
+    int blk, blk1;
     uint8_t *exp, *exp_strategy;
     int nb_coefs, num_reuse_blocks;
 
-    for (ch = !s->cpl_on; ch <= s->channels; ch++) {
-        exp          = s->blocks[0].exp[ch] + s->start_freq[ch];
-        exp_strategy = s->exp_strategy[ch];
+    exp          = s->blocks[0].exp[ch] + s->start_freq[ch];
+    exp_strategy = s->exp_strategy[ch];
 
-        cpl = (ch == CPL_CH);
-        blk = 0;
-        while (blk < s->num_blocks) {
-            AC3Block *block = &s->blocks[blk];
-            if (cpl && !block->cpl_in_use) {
-                exp += AC3_MAX_COEFS;
-                blk++;
-                continue;
-            }
-            nb_coefs = block->end_freq[ch] - s->start_freq[ch];
-            blk1 = blk + 1;
+    blk = 0;
+    while (blk < s->num_blocks) {
+        AC3Block *block = &s->blocks[blk];
+        if (cpl && !block->cpl_in_use) {
+            exp += AC3_MAX_COEFS;
+            blk++;
+            continue;
+        }
+        nb_coefs = block->end_freq[ch] - s->start_freq[ch];
+        blk1 = blk + 1;
 
-            /* count the number of EXP_REUSE blocks after the current block
-               and set exponent reference block numbers */
-            s->exp_ref_block[ch][blk] = blk;
-            while (blk1 < s->num_blocks && exp_strategy[blk1] == EXP_REUSE) {
-                s->exp_ref_block[ch][blk1] = blk;
-                blk1++;
-            }
-            num_reuse_blocks = blk1 - blk - 1;
+        /* count the number of EXP_REUSE blocks after the current block
+           and set exponent reference block numbers */
+        s->exp_ref_block[ch][blk] = blk;
+        while (blk1 < s->num_blocks && exp_strategy[blk1] == EXP_REUSE) {
+            s->exp_ref_block[ch][blk1] = blk;
+            blk1++;
+        }
+        num_reuse_blocks = blk1 - blk - 1;
 
-            /* for the EXP_REUSE case we select the min of the exponents */
-            s->ac3dsp.ac3_exponent_min(exp-s->start_freq[ch], num_reuse_blocks,
-                                       AC3_MAX_COEFS);
+        /* for the EXP_REUSE case we select the min of the exponents */
+        s->ac3dsp.ac3_exponent_min(exp-s->start_freq[ch], num_reuse_blocks,
+                                   AC3_MAX_COEFS);
 
-            encode_exponents_blk_ch(exp, nb_coefs, exp_strategy[blk], cpl);
+        encode_exponents_blk_ch(exp, nb_coefs, exp_strategy[blk], cpl);
 
-            exp += AC3_MAX_COEFS * (num_reuse_blocks + 1);
-            blk = blk1;
-        }
+        exp += AC3_MAX_COEFS * (num_reuse_blocks + 1);
+        blk = blk1;
     }
+    emms_c();
+
+    return 0;
+}
+
+
+/*
+ * Encode exponents of all channels, each channel is processed by a
+ * separate job.
+ */
+static void encode_exponents(AC3EncodeContext *s)
+{
+    s->avctx->execute2(s->avctx, encode_exponents_ch, NULL, NULL,
+                       s->channels + s->cpl_on);
 
     /* reference block numbers have been changed, so reset ref_bap_set */
     s->ref_bap_set = 0;
@@ -641,8 +656,6 @@ void ff_ac3_process_exponents(AC3EncodeContext *s)
     compute_exp_strategy(s);
 
     encode_exponents(s);
-
-    emms_c();
 }
 
 
@@ -1292,6 +1305,37 @@ static void quantize_mantissas_blk_ch(AC3Mant *s, int32_t *fixed_coef,
 }
 
 
+/**
+ * Quantize the mantissas of one block using coefficients, exponents, and bit
+ * allocation pointers. Mantissa grouping spans the channels of a block, so
+ * blocks are the unit of parallel work.
+ */
+static int quantize_mantissas_blk(AVCodecContext *avctx, void *arg, int blk, int threadnr)
+{
+    AC3EncodeContext *s = avctx->priv_data;
+    AC3Block *block = &s->blocks[blk];
+    AC3Mant m = { 0 };
+    int ch, ch0 = 0, got_cpl;
+
+    got_cpl = !block->cpl_in_use;
+    for (ch = 1; ch <= s->channels; ch++) {
+        if (!got_cpl && ch > 1 && block->channel_in_cpl[ch-1]) {
+            ch0     = ch - 1;
+            ch      = CPL_CH;
+            got_cpl = 1;
+        }
+        quantize_mantissas_blk_ch(&m, block->fixed_coef[ch],
+                                  s->blocks[s->exp_ref_block[ch][blk]].exp[ch],
+                                  s->ref_bap[ch][blk], block->qmant[ch],
+                                  s->start_freq[ch], block->end_freq[ch]);
+        if (ch == CPL_CH)
+            ch = ch0;
+    }
+
+    return 0;
+}
+
+
 /**
  * Quantize mantissas using coefficients, exponents, and bit allocation pointers.
  *
@@ -1299,27 +1343,8 @@ static void quantize_mantissas_blk_ch(AC3Mant *s, int32_t *fixed_coef,
  */
 void ff_ac3_quantize_mantissas(AC3EncodeContext *s)
 {
-    int blk, ch, ch0=0, got_cpl;
-
-    for (blk = 0; blk < s->num_blocks; blk++) {
-        AC3Block *block = &s->blocks[blk];
-        AC3Mant m = { 0 };
-
-        got_cpl = !block->cpl_in_use;
-        for (ch = 1; ch <= s->channels; ch++) {
-            if (!got_cpl && ch > 1 && block->channel_in_cpl[ch-1]) {
-                ch0     = ch - 1;
-                ch      = CPL_CH;
-                got_cpl = 1;
-            }
-            quantize_mantissas_blk_ch(&m, block->fixed_coef[ch],
-                                      s->blocks[s->exp_ref_block[ch][blk]].exp[ch],
-                                      s->ref_bap[ch][blk], block->qmant[ch],
-                                      s->start_freq[ch], block->end_freq[ch]);
-            if (ch == CPL_CH)
-                ch = ch0;
-        }
-    }
+    s->avctx->execute2(s->avctx, quantize_mantissas_blk, NULL, NULL,
+                       s->num_blocks);
 }
 
 
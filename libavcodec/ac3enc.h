@@ -233,7 +233,7 @@ typedef struct AC3EncodeContext {
     int frame_bits;                         ///< all frame bits except exponents and mantissas
     int exponent_bits;                      ///< number of bits used for exponents
 
-    SampleType *windowed_samples;
+    SampleType *windowed_samples;           ///< windowed input, one block per channel
     SampleType **planar_samples;
     uint8_t *bap_buffer;
     uint8_t *bap1_buffer;
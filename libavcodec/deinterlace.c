@@ -26,6 +26,7 @@
 
 #include "deinterlace.h"
 #include "internal.h"
+#include "mathops.h"
 
 #include "libavutil/common.h"
 #include "libavutil/pixdesc.h"
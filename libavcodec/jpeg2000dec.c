@@ -87,6 +87,18 @@ typedef struct Jpeg2000Tile {
     int coord[2][2];                    // border coordinates {{x0, x1}, {y0, y1}}
 } Jpeg2000Tile;
 
+/* A single code-block of a tile, decoded as one slice-thread job when
+ * there are fewer tiles than threads. */
+typedef struct Jpeg2000CblkJob {
+    Jpeg2000Component   *comp;
+    Jpeg2000CodingStyle *codsty;
+    Jpeg2000Band        *band;
+    Jpeg2000Cblk        *cblk;
+    int                 bandpos;
+    int                 compno;
+    int                 coded;
+} Jpeg2000CblkJob;
+
 typedef struct Jpeg2000DecoderContext {
     AVClass         *class;
     AVCodecContext  *avctx;
@@ -121,6 +133,11 @@ typedef struct Jpeg2000DecoderContext {
     Jpeg2000Tile    *tile;
     Jpeg2000DSPContext dsp;
 
+    Jpeg2000CblkJob *cblk_jobs;
+    unsigned int    cblk_jobs_size;
+    int             nb_cblk_jobs;
+    int             coded[4];   // if a component of the current tile has coded code-blocks
+
     /*options parameters*/
     int             reduction_factor;
 } Jpeg2000DecoderContext;
@@ -1697,6 +1714,39 @@ static inline void mct_decode(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
     s->dsp.mct_decode[tile->codsty[0].transform](src[0], src[1], src[2], csize);
 }
 
+static int decode_cblk_dequant(Jpeg2000DecoderContext *s, Jpeg2000T1Context *t1,
+                               Jpeg2000Component *comp, Jpeg2000CodingStyle *codsty,
+                               Jpeg2000Band *band, Jpeg2000Cblk *cblk, int bandpos)
+{
+    int x, y;
+    int ret = decode_cblk(s, codsty, t1, cblk,
+                          cblk->coord[0][1] - cblk->coord[0][0],
+                          cblk->coord[1][1] - cblk->coord[1][0],
+                          bandpos);
+    if (!ret)
+        return 0;
+
+    x = cblk->coord[0][0] - band->coord[0][0];
+    y = cblk->coord[1][0] - band->coord[1][0];
+
+    if (codsty->transform == FF_DWT97)
+        dequantization_float(x, y, cblk, comp, t1, band);
+    else if (codsty->transform == FF_DWT97_INT)
+        dequantization_int_97(x, y, cblk, comp, t1, band);
+    else
+        dequantization_int(x, y, cblk, comp, t1, band);
+
+    return 1;
+}
+
+static inline void dwt_decode_comp(Jpeg2000Tile *tile, int compno)
+{
+    Jpeg2000Component *comp     = tile->comp + compno;
+    Jpeg2000CodingStyle *codsty = tile->codsty + compno;
+
+    ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
+}
+
 static inline void tile_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
 {
     Jpeg2000T1Context t1;
@@ -1735,25 +1785,9 @@ static inline void tile_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile
                     for (cblkno = 0;
                          cblkno < prec->nb_codeblocks_width * prec->nb_codeblocks_height;
                          cblkno++) {
-                        int x, y;
                         Jpeg2000Cblk *cblk = prec->cblk + cblkno;
-                        int ret = decode_cblk(s, codsty, &t1, cblk,
-                                    cblk->coord[0][1] - cblk->coord[0][0],
-                                    cblk->coord[1][1] - cblk->coord[1][0],
-                                    bandpos);
-                        if (ret)
+                        if (decode_cblk_dequant(s, &t1, comp, codsty, band, cblk, bandpos))
                             coded = 1;
-                        else
-                            continue;
-                        x = cblk->coord[0][0] - band->coord[0][0];
-                        y = cblk->coord[1][0] - band->coord[1][0];
-
-                        if (codsty->transform == FF_DWT97)
-                            dequantization_float(x, y, cblk, comp, &t1, band);
-                        else if (codsty->transform == FF_DWT97_INT)
-                            dequantization_int_97(x, y, cblk, comp, &t1, band);
-                        else
-                            dequantization_int(x, y, cblk, comp, &t1, band);
                    } /* end cblk */
                 } /*end prec */
             } /* end band */
@@ -1761,11 +1795,88 @@ static inline void tile_codeblocks(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile
 
         /* inverse DWT */
         if (coded)
-            ff_dwt_decode(&comp->dwt, codsty->transform == FF_DWT97 ? (void*)comp->f_data : (void*)comp->i_data);
+            dwt_decode_comp(tile, compno);
 
     } /*end comp */
 }
 
+/* Gather all code-blocks of a tile into s->cblk_jobs so that they can be
+ * decoded in parallel. */
+static int tile_codeblock_jobs(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile)
+{
+    int compno, reslevelno, bandno, precno, cblkno;
+    int nb_jobs = 0;
+
+    for (compno = 0; compno < s->ncomponents; compno++) {
+        Jpeg2000Component *comp     = tile->comp + compno;
+        Jpeg2000CodingStyle *codsty = tile->codsty + compno;
+
+        for (reslevelno = 0; reslevelno < codsty->nreslevels2decode; reslevelno++) {
+            Jpeg2000ResLevel *rlevel = comp->reslevel + reslevelno;
+            for (bandno = 0; bandno < rlevel->nbands; bandno++) {
+                Jpeg2000Band *band = rlevel->band + bandno;
+
+                if (band->coord[0][0] == band->coord[0][1] ||
+                    band->coord[1][0] == band->coord[1][1])
+                    continue;
+
+                for (precno = 0; precno < rlevel->num_precincts_x * rlevel->num_precincts_y; precno++) {
+                    Jpeg2000Prec *prec = band->prec + precno;
+                    int nb_cblks = prec->nb_codeblocks_width * prec->nb_codeblocks_height;
+                    Jpeg2000CblkJob *jobs;
+
+                    if (nb_cblks > INT_MAX / sizeof(*jobs) - nb_jobs)
+                        return AVERROR(ENOMEM);
+                    jobs = av_fast_realloc(s->cblk_jobs, &s->cblk_jobs_size,
+                                           (nb_jobs + nb_cblks) * sizeof(*jobs));
+                    if (!jobs)
+                        return AVERROR(ENOMEM);
+                    s->cblk_jobs = jobs;
+
+                    for (cblkno = 0; cblkno < nb_cblks; cblkno++) {
+                        Jpeg2000CblkJob *job = &jobs[nb_jobs++];
+                        job->comp    = comp;
+                        job->codsty  = codsty;
+                        job->band    = band;
+                        job->cblk    = prec->cblk + cblkno;
+                        job->bandpos = bandno + (reslevelno > 0);
+                        job->compno  = compno;
+                        job->coded   = 0;
+                    }
+                }
+            }
+        }
+    }
+    s->nb_cblk_jobs = nb_jobs;
+
+    return 0;
+}
+
+static int jpeg2000_decode_cblk_job(AVCodecContext *avctx, void *td,
+                                    int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000CblkJob *job      = s->cblk_jobs + jobnr;
+    Jpeg2000T1Context t1;
+
+    t1.stride  = (1<<job->codsty->log2_cblk_width) + 2;
+    job->coded = decode_cblk_dequant(s, &t1, job->comp, job->codsty,
+                                     job->band, job->cblk, job->bandpos);
+
+    return 0;
+}
+
+static int jpeg2000_dwt_comp(AVCodecContext *avctx, void *td,
+                             int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+
+    if (s->coded[jobnr])
+        dwt_decode_comp(td, jobnr);
+
+    return 0;
+}
+
 #define WRITE_FRAME(D, PIXEL)                                                                     \
     static inline void write_frame_ ## D(Jpeg2000DecoderContext * s, Jpeg2000Tile * tile,         \
                                          AVFrame * picture, int precision)                        \
@@ -1828,16 +1939,11 @@ WRITE_FRAME(16, uint16_t)
 
 #undef WRITE_FRAME
 
-static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
-                                int jobnr, int threadnr)
+static void jpeg2000_output_tile(Jpeg2000DecoderContext *s, Jpeg2000Tile *tile,
+                                 AVFrame *picture)
 {
-    Jpeg2000DecoderContext *s = avctx->priv_data;
-    AVFrame *picture = td;
-    Jpeg2000Tile *tile = s->tile + jobnr;
     int x;
 
-    tile_codeblocks(s, tile);
-
     /* inverse MCT transformation */
     if (tile->codsty[0].mct)
         mct_decode(s, tile);
@@ -1863,6 +1969,43 @@ static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
 
         write_frame_16(s, tile, picture, precision);
     }
+}
+
+static int jpeg2000_decode_tile(AVCodecContext *avctx, void *td,
+                                int jobnr, int threadnr)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+    Jpeg2000Tile *tile = s->tile + jobnr;
+
+    tile_codeblocks(s, tile);
+    jpeg2000_output_tile(s, tile, td);
+
+    return 0;
+}
+
+/* Decode the tiles one after the other, spreading the code-blocks of each
+ * tile and then its components' inverse DWT across the slice threads. */
+static int jpeg2000_decode_tiles_cblk_threaded(AVCodecContext *avctx, AVFrame *picture)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+    int tileno, i, ret;
+
+    for (tileno = 0; tileno < s->numXtiles * s->numYtiles; tileno++) {
+        Jpeg2000Tile *tile = s->tile + tileno;
+
+        if ((ret = tile_codeblock_jobs(s, tile)) < 0)
+            return ret;
+
+        avctx->execute2(avctx, jpeg2000_decode_cblk_job, NULL, NULL, s->nb_cblk_jobs);
+
+        memset(s->coded, 0, sizeof(s->coded));
+        for (i = 0; i < s->nb_cblk_jobs; i++)
+            s->coded[s->cblk_jobs[i].compno] |= s->cblk_jobs[i].coded;
+
+        avctx->execute2(avctx, jpeg2000_dwt_comp, tile, NULL, s->ncomponents);
+
+        jpeg2000_output_tile(s, tile, picture);
+    }
 
     return 0;
 }
@@ -2241,7 +2384,13 @@ static int jpeg2000_decode_frame(AVCodecContext *avctx, void *data,
     if (ret = jpeg2000_read_bitstream_packets(s))
         goto end;
 
-    avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
+    if (avctx->active_thread_type & FF_THREAD_SLICE &&
+        s->numXtiles * s->numYtiles < avctx->thread_count) {
+        if ((ret = jpeg2000_decode_tiles_cblk_threaded(avctx, picture)) < 0)
+            goto end;
+    } else {
+        avctx->execute2(avctx, jpeg2000_decode_tile, picture, NULL, s->numXtiles * s->numYtiles);
+    }
 
     jpeg2000_dec_cleanup(s);
 
@@ -2260,6 +2409,16 @@ end:
     return ret;
 }
 
+static av_cold int jpeg2000_decode_close(AVCodecContext *avctx)
+{
+    Jpeg2000DecoderContext *s = avctx->priv_data;
+
+    av_freep(&s->cblk_jobs);
+    s->cblk_jobs_size = 0;
+
+    return 0;
+}
+
 #define OFFSET(x) offsetof(Jpeg2000DecoderContext, x)
 #define VD AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_DECODING_PARAM
 
@@ -2285,6 +2444,7 @@ AVCodec ff_jpeg2000_decoder = {
     .priv_data_size   = sizeof(Jpeg2000DecoderContext),
     .init             = jpeg2000_decode_init,
     .decode           = jpeg2000_decode_frame,
+    .close            = jpeg2000_decode_close,
     .priv_class       = &jpeg2000_class,
     .max_lowres       = 5,
     .profiles         = NULL_IF_CONFIG_SMALL(ff_jpeg2000_profiles)
@@ -305,6 +305,33 @@ static void dwt_encode97_int(DWTContext *s, int *t)
         t[i] = (t[i] + ((1<<I_PRESHIFT)>>1)) >> I_PRESHIFT;
 }
 
+static void lift_float_c(float *dst, const float *src0, const float *src1,
+                         float coef, int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        dst[i] += coef * (src0[i] + src1[i]);
+}
+
+static void lift53_low_c(int32_t *dst, const int32_t *src0, const int32_t *src1,
+                         int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        dst[i] -= (int)((unsigned)src0[i] + src1[i] + 2) >> 2;
+}
+
+static void lift53_high_c(int32_t *dst, const int32_t *src0, const int32_t *src1,
+                          int len)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        dst[i] += (int)((unsigned)src0[i] + src1[i]) >> 1;
+}
+
 static void sr_1d53(unsigned *p, int i0, int i1)
 {
     int i;
@@ -323,11 +350,37 @@ static void sr_1d53(unsigned *p, int i0, int i1)
         p[2 * i + 1] += (int)(p[2 * i] + p[2 * i + 2]) >> 1;
 }
 
+/* Vertical 5/3 synthesis of FF_DWT_STRIP columns at once, p[k * FF_DWT_STRIP]
+ * holds row k of the interleaved strip. */
+static void sr_1d53_strip(int32_t *p, int i0, int i1, int width)
+{
+    const int S = FF_DWT_STRIP;
+    int i;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (i = 0; i < width; i++)
+                p[S + i] >>= 1;
+        return;
+    }
+
+    memcpy(p + (i0 - 1) * S, p + (i0 + 1) * S, S * sizeof(*p));
+    memcpy(p +  i1      * S, p + (i1 - 2) * S, S * sizeof(*p));
+    memcpy(p + (i0 - 2) * S, p + (i0 + 2) * S, S * sizeof(*p));
+    memcpy(p + (i1 + 1) * S, p + (i1 - 3) * S, S * sizeof(*p));
+
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        lift53_low_c(p + 2 * i * S, p + (2 * i - 1) * S, p + (2 * i + 1) * S, width);
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        lift53_high_c(p + (2 * i + 1) * S, p + 2 * i * S, p + (2 * i + 2) * S, width);
+}
+
 static void dwt_decode53(DWTContext *s, int *t)
 {
     int lev;
     int w     = s->linelen[s->ndeclevels - 1][0];
-    int32_t *line = s->i_linebuf;
+    int32_t *line  = s->i_linebuf;
+    int32_t *strip = s->i_stripbuf + 5 * FF_DWT_STRIP;
     line += 3;
 
     for (lev = 0; lev < s->ndeclevels; lev++) {
@@ -355,19 +408,19 @@ static void dwt_decode53(DWTContext *s, int *t)
         }
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = strip + mv * FF_DWT_STRIP;
+        for (lp = 0; lp < lh; lp += FF_DWT_STRIP) {
+            int i, j = 0, n = FFMIN(FF_DWT_STRIP, lh - lp);
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = t[w * j + lp];
+                memcpy(l + i * FF_DWT_STRIP, t + w * j + lp, n * sizeof(*t));
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = t[w * j + lp];
+                memcpy(l + i * FF_DWT_STRIP, t + w * j + lp, n * sizeof(*t));
 
-            sr_1d53(line, mv, mv + lv);
+            sr_1d53_strip(strip, mv, mv + lv, n);
 
             for (i = 0; i < lv; i++)
-                t[w * i + lp] = l[i];
+                memcpy(t + w * i + lp, l + i * FF_DWT_STRIP, n * sizeof(*t));
         }
     }
 }
@@ -399,12 +452,52 @@ static void sr_1d97_float(float *p, int i0, int i1)
         p[2 * i + 1] += F_LFTG_ALPHA * (p[2 * i]     + p[2 * i + 2]);
 }
 
+/* Vertical 9/7 synthesis of FF_DWT_STRIP columns at once, p[k * FF_DWT_STRIP]
+ * holds row k of the interleaved strip. */
+static void sr_1d97_float_strip(float *p, int i0, int i1, int width)
+{
+    const int S = FF_DWT_STRIP;
+    int i;
+
+    if (i1 <= i0 + 1) {
+        if (i0 == 1)
+            for (i = 0; i < width; i++)
+                p[S + i] *= F_LFTG_K/2;
+        else
+            for (i = 0; i < width; i++)
+                p[i] *= F_LFTG_X;
+        return;
+    }
+
+    for (i = 1; i <= 4; i++) {
+        memcpy(p + (i0 - i)     * S, p + (i0 + i)     * S, S * sizeof(*p));
+        memcpy(p + (i1 + i - 1) * S, p + (i1 - i - 1) * S, S * sizeof(*p));
+    }
+
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 2; i++)
+        lift_float_c(p + 2 * i * S, p + (2 * i - 1) * S, p + (2 * i + 1) * S,
+                     -F_LFTG_DELTA, width);
+    /* step 4 */
+    for (i = (i0 >> 1) - 1; i < (i1 >> 1) + 1; i++)
+        lift_float_c(p + (2 * i + 1) * S, p + 2 * i * S, p + (2 * i + 2) * S,
+                     -F_LFTG_GAMMA, width);
+    /*step 5*/
+    for (i = (i0 >> 1); i < (i1 >> 1) + 1; i++)
+        lift_float_c(p + 2 * i * S, p + (2 * i - 1) * S, p + (2 * i + 1) * S,
+                     F_LFTG_BETA, width);
+    /* step 6 */
+    for (i = (i0 >> 1); i < (i1 >> 1); i++)
+        lift_float_c(p + (2 * i + 1) * S, p + 2 * i * S, p + (2 * i + 2) * S,
+                     F_LFTG_ALPHA, width);
+}
+
 static void dwt_decode97_float(DWTContext *s, float *t)
 {
     int lev;
     int w       = s->linelen[s->ndeclevels - 1][0];
-    float *line = s->f_linebuf;
-    float *data = t;
+    float *line  = s->f_linebuf;
+    float *strip = s->f_stripbuf + 5 * FF_DWT_STRIP;
+    float *data  = t;
     /* position at index O of line range [0-5,w+5] cf. extend function */
     line += 5;
 
@@ -432,19 +525,19 @@ static void dwt_decode97_float(DWTContext *s, float *t)
         }
 
         // VER_SD
-        l = line + mv;
-        for (lp = 0; lp < lh; lp++) {
-            int i, j = 0;
+        l = strip + mv * FF_DWT_STRIP;
+        for (lp = 0; lp < lh; lp += FF_DWT_STRIP) {
+            int i, j = 0, n = FFMIN(FF_DWT_STRIP, lh - lp);
             // copy with interleaving
             for (i = mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                memcpy(l + i * FF_DWT_STRIP, data + w * j + lp, n * sizeof(*data));
             for (i = 1 - mv; i < lv; i += 2, j++)
-                l[i] = data[w * j + lp];
+                memcpy(l + i * FF_DWT_STRIP, data + w * j + lp, n * sizeof(*data));
 
-            sr_1d97_float(line, mv, mv + lv);
+            sr_1d97_float_strip(strip, mv, mv + lv, n);
 
             for (i = 0; i < lv; i++)
-                data[w * i + lp] = l[i];
+                memcpy(data + w * i + lp, l + i * FF_DWT_STRIP, n * sizeof(*data));
         }
     }
 }
@@ -556,10 +649,12 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
             for (j = 0; j < 2; j++)
                 b[i][j] = (b[i][j] + 1) >> 1;
         }
+
     switch (type) {
     case FF_DWT97:
-        s->f_linebuf = av_malloc_array((maxlen + 12), sizeof(*s->f_linebuf));
-        if (!s->f_linebuf)
+        s->f_linebuf  = av_malloc_array((maxlen + 12), sizeof(*s->f_linebuf));
+        s->f_stripbuf = av_mallocz_array((maxlen + 12) * FF_DWT_STRIP, sizeof(*s->f_stripbuf));
+        if (!s->f_linebuf || !s->f_stripbuf)
             return AVERROR(ENOMEM);
         break;
      case FF_DWT97_INT:
@@ -568,8 +663,9 @@ int ff_jpeg2000_dwt_init(DWTContext *s, int border[2][2],
             return AVERROR(ENOMEM);
         break;
     case FF_DWT53:
-        s->i_linebuf = av_malloc_array((maxlen +  6), sizeof(*s->i_linebuf));
-        if (!s->i_linebuf)
+        s->i_linebuf  = av_malloc_array((maxlen +  6), sizeof(*s->i_linebuf));
+        s->i_stripbuf = av_mallocz_array((maxlen + 12) * FF_DWT_STRIP, sizeof(*s->i_stripbuf));
+        if (!s->i_linebuf || !s->i_stripbuf)
             return AVERROR(ENOMEM);
         break;
     default:
@@ -621,4 +717,6 @@ void ff_dwt_destroy(DWTContext *s)
 {
     av_freep(&s->f_linebuf);
     av_freep(&s->i_linebuf);
+    av_freep(&s->f_stripbuf);
+    av_freep(&s->i_stripbuf);
 }
@@ -30,6 +30,7 @@
 #include <stdint.h>
 
 #define FF_DWT_MAX_DECLVLS 32 ///< max number of decomposition levels
+#define FF_DWT_STRIP       32 ///< number of columns lifted together in the vertical pass
 #define F_LFTG_K      1.230174104914001f
 #define F_LFTG_X      0.812893066115961f
 
@@ -48,6 +49,8 @@ typedef struct DWTContext {
     uint8_t type;                        ///< 0 for 9/7; 1 for 5/3
     int32_t *i_linebuf;                  ///< int buffer used by transform
     float   *f_linebuf;                  ///< float buffer used by transform
+    int32_t *i_stripbuf;                 ///< int column strip buffer used by the inverse transform
+    float   *f_stripbuf;                 ///< float column strip buffer used by the inverse transform
 } DWTContext;
 
 /**
@@ -30,6 +30,7 @@
 #include "mpegutils.h"
 #include "mpegvideo.h"
 #include "msmpeg4data.h"
+#include "thread.h"
 #include "unary.h"
 #include "vc1.h"
 #include "vc1_pred.h"
@@ -69,6 +70,46 @@ static inline void init_block_index(VC1Context *v)
 
 /** @} */ //Bitplane group
 
+/** Wait until the reference pictures are final in all the rows motion
+ * compensation of the current macroblock row may access.
+ */
+static void vc1_await_references(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+    int row = INT_MAX;
+
+    if (!(s->avctx->active_thread_type & FF_THREAD_FRAME))
+        return;
+
+    /* Progress is only reported for frame pictures; MVs are wrapped to
+     * range_y quarter-pels, field MVs of interlaced frames cover twice as
+     * many lines, and the interpolation filters need a few more. */
+    if (!v->field_mode) {
+        int mv_y = ((v->range_y >> 2) << (v->fcm == ILACE_FRAME)) + 4;
+        row = FFMIN(s->mb_y + 1 + ((mv_y + 15) >> 4), s->mb_height - 1);
+    }
+
+    if (s->last_picture_ptr)
+        ff_thread_await_progress(&s->last_picture_ptr->tf, row, 0);
+    if (s->pict_type == AV_PICTURE_TYPE_B && s->next_picture_ptr)
+        ff_thread_await_progress(&s->next_picture_ptr->tf, row, 0);
+}
+
+/** Report the rows of a reference frame picture that will not be modified
+ * anymore. Overlap smoothing and the loop filter run up to two macroblock
+ * rows behind the current one and touch the bottom of the row above.
+ * Once an error occurred, error concealment may still rewrite the following
+ * rows, so only ff_mpv_frame_end() reports progress then.
+ */
+static void vc1_report_decode_progress(VC1Context *v)
+{
+    MpegEncContext *s = &v->s;
+
+    if (!v->field_mode && s->pict_type != AV_PICTURE_TYPE_B &&
+        s->mb_y >= 3 && !s->er.error_occurred)
+        ff_thread_report_progress(&s->current_picture_ptr->tf, s->mb_y - 3, 0);
+}
+
 static void vc1_put_blocks_clamped(VC1Context *v, int put_signed)
 {
     MpegEncContext *s = &v->s;
@@ -2648,6 +2689,7 @@ static void vc1_decode_i_blocks(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_decode_progress(v);
 
         s->first_slice_line = 0;
     }
@@ -2794,6 +2836,7 @@ static int vc1_decode_i_blocks_adv(VC1Context *v)
             ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
         else if (s->mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y-1) * 16, 16);
+        vc1_report_decode_progress(v);
         s->first_slice_line = 0;
     }
 
@@ -2840,6 +2883,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2888,6 +2932,7 @@ static void vc1_decode_p_blocks(VC1Context *v)
                 sizeof(v->luma_mv_base[0]) * 2 * s->mb_stride);
         if (s->mb_y != s->start_mb_y)
             ff_mpeg_draw_horiz_band(s, (s->mb_y - 1) * 16, 16);
+        vc1_report_decode_progress(v);
         s->first_slice_line = 0;
     }
     if (s->end_mb_y >= s->start_mb_y)
@@ -2929,6 +2974,7 @@ static void vc1_decode_b_blocks(VC1Context *v)
     for (s->mb_y = s->start_mb_y; s->mb_y < s->end_mb_y; s->mb_y++) {
         s->mb_x = 0;
         init_block_index(v);
+        vc1_await_references(v);
         for (; s->mb_x < s->mb_width; s->mb_x++) {
             ff_update_block_index(s);
 
@@ -2993,10 +3039,12 @@ static void vc1_decode_skip_blocks(VC1Context *v)
         s->mb_x = 0;
         init_block_index(v);
         ff_update_block_index(s);
+        vc1_await_references(v);
         memcpy(s->dest[0], s->last_picture.f->data[0] + s->mb_y * 16 * s->linesize,   s->linesize   * 16);
         memcpy(s->dest[1], s->last_picture.f->data[1] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         memcpy(s->dest[2], s->last_picture.f->data[2] + s->mb_y *  8 * s->uvlinesize, s->uvlinesize *  8);
         ff_mpeg_draw_horiz_band(s, s->mb_y * 16, 16);
+        vc1_report_decode_progress(v);
         s->first_slice_line = 0;
     }
     s->pict_type = AV_PICTURE_TYPE_P;
@@ -36,6 +36,7 @@
 #include "msmpeg4.h"
 #include "msmpeg4data.h"
 #include "profiles.h"
+#include "thread.h"
 #include "vc1.h"
 #include "vc1data.h"
 #include "libavutil/avassert.h"
@@ -628,6 +629,80 @@ av_cold int ff_vc1_decode_end(AVCodecContext *avctx)
 }
 
 
+static av_cold int vc1_decode_init_thread_copy(AVCodecContext *avctx)
+{
+    VC1Context *v = avctx->priv_data;
+
+    // the copied context still points to the sprite frame of the first thread
+    v->sprite_output_frame = av_frame_alloc();
+    if (!v->sprite_output_frame)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int vc1_update_thread_context(AVCodecContext *dst, const AVCodecContext *src)
+{
+    VC1Context *v = dst->priv_data;
+    const VC1Context *v1 = src->priv_data;
+    MpegEncContext *s = &v->s;
+    const MpegEncContext *s1 = &v1->s;
+    int i, ret, mv_f_size;
+
+    if (dst == src || !s1->context_initialized)
+        return 0;
+
+    if (s->context_initialized &&
+        (s->width != s1->width || s->height != s1->height))
+        ff_vc1_decode_end(dst);
+
+    if ((ret = ff_mpeg_update_thread_context(dst, src)) < 0)
+        return ret;
+
+    if (!v->mv_type_mb_plane) {
+        if ((ret = ff_vc1_decode_init_alloc_tables(v)) < 0)
+            return ret;
+    }
+
+#define COPY_FIELDS(first, end)                                          \
+    memcpy(&v->first, &v1->first,                                        \
+           offsetof(VC1Context, end) - offsetof(VC1Context, first))
+
+    // sequence header, entry point and previous picture header state
+    COPY_FIELDS(res_sprite,          ttblk_base);
+    COPY_FIELDS(codingset,           mb_type_base);
+    COPY_FIELDS(lumscale,            mv_type_mb_plane);
+    COPY_FIELDS(mv_type_is_raw,      curr_luty);
+    COPY_FIELDS(rnd,                 acpred_plane);
+    COPY_FIELDS(range_mapy_flag,     fieldtx_plane);
+    COPY_FIELDS(fieldtx_is_raw,      blk_mv_type_base);
+    COPY_FIELDS(field_mode,          new_sprite);
+    COPY_FIELDS(p_frame_skipped,     block);
+    COPY_FIELDS(bfraction_lut_index, parse_only);
+#undef COPY_FIELDS
+
+    // intensity compensation, the current tables point into the context
+    v->last_use_ic = v1->last_use_ic;
+    v->next_use_ic = v1->next_use_ic;
+    v->aux_use_ic  = v1->aux_use_ic;
+    v->curr_use_ic = v1->curr_use_ic == &v1->aux_use_ic ? &v->aux_use_ic : &v->next_use_ic;
+    v->curr_luty   = v1->curr_luty   == v1->aux_luty    ? v->aux_luty    : v->next_luty;
+    v->curr_lutuv  = v1->curr_lutuv  == v1->aux_lutuv   ? v->aux_lutuv   : v->next_lutuv;
+
+    s->loop_filter = s1->loop_filter;
+    s->h_edge_pos  = s1->h_edge_pos;
+    s->v_edge_pos  = s1->v_edge_pos;
+
+    // field MV flags of the last anchor, used by field B pictures
+    mv_f_size = s->b8_stride * (FFALIGN(s->mb_height, 2) * 2 + 1) +
+                s->mb_stride * (FFALIGN(s->mb_height, 2) + 1) * 2;
+    for (i = 0; i < 2; i++)
+        memcpy(v->mv_f_next[i] - s->b8_stride - 1,
+               v1->mv_f_next[i] - s1->b8_stride - 1, mv_f_size);
+
+    return 0;
+}
+
 /** Decode a VC1/WMV3 frame
  * @todo TODO: Handle VC-1 IDUs (Transport level?)
  */
@@ -642,6 +717,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     uint8_t *buf2 = NULL;
     const uint8_t *buf_start = buf, *buf_start_second_field = NULL;
     int mb_height, n_slices1=-1;
+    int frame_started = 0;
     struct {
         uint8_t *buf;
         GetBitContext gb;
@@ -891,6 +967,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     if ((ret = ff_mpv_frame_start(s, avctx)) < 0) {
         goto err;
     }
+    frame_started = 1;
 
     v->s.current_picture_ptr->field_picture = v->field_mode;
     v->s.current_picture_ptr->f->interlaced_frame = (v->fcm != PROGRESSIVE);
@@ -908,6 +985,11 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
         s->current_picture_ptr->f->repeat_pict = v->rptfrm * 2;
     }
 
+    /* Field pictures update the field MV flags of the anchor while decoding,
+     * so the next frame thread may only start once they are done. */
+    if (!v->field_mode)
+        ff_thread_finish_setup(avctx);
+
     s->me.qpel_put = s->qdsp.put_qpel_pixels_tab;
     s->me.qpel_avg = s->qdsp.avg_qpel_pixels_tab;
 
@@ -1126,6 +1208,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
                 FFSWAP(uint8_t *, v->mv_f_next[0], v->mv_f[0]);
                 FFSWAP(uint8_t *, v->mv_f_next[1], v->mv_f[1]);
             }
+            ff_thread_finish_setup(avctx);
         }
         ff_dlog(s->avctx, "Consumed %i/%i bits\n",
                 get_bits_count(&s->gb), s->gb.size_in_bits);
@@ -1140,6 +1223,7 @@ static int vc1_decode_frame(AVCodecContext *avctx, void *data,
     }
 
     ff_mpv_frame_end(s);
+    frame_started = 0;
 
     if (avctx->codec_id == AV_CODEC_ID_WMV3IMAGE || avctx->codec_id == AV_CODEC_ID_VC1IMAGE) {
 image:
@@ -1176,6 +1260,9 @@ end:
     return buf_size;
 
 err:
+    /* let frame threads waiting on this picture proceed */
+    if (frame_started)
+        ff_mpv_frame_end(s);
     av_free(buf2);
     for (i = 0; i < n_slices; i++)
         av_free(slices[i].buf);
@@ -1215,7 +1302,9 @@ AVCodec ff_vc1_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_FRAME_THREADS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal*[]) {
 #if CONFIG_VC1_DXVA2_HWACCEL
@@ -1252,7 +1341,9 @@ AVCodec ff_wmv3_decoder = {
     .close          = ff_vc1_decode_end,
     .decode         = vc1_decode_frame,
     .flush          = ff_mpeg_flush,
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY,
+    .init_thread_copy      = ONLY_IF_THREADS_ENABLED(vc1_decode_init_thread_copy),
+    .update_thread_context = ONLY_IF_THREADS_ENABLED(vc1_update_thread_context),
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_FRAME_THREADS,
     .pix_fmts       = vc1_hwaccel_pixfmt_list_420,
     .hw_configs     = (const AVCodecHWConfigInternal*[]) {
 #if CONFIG_WMV3_DXVA2_HWACCEL
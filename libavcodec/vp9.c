@@ -33,15 +33,54 @@
 #include "vp9data.h"
 #include "vp9dec.h"
 #include "libavutil/avassert.h"
+#include "libavutil/opt.h"
 #include "libavutil/pixdesc.h"
+#include "libavutil/slicethread.h"
 
 #define VP9_SYNCCODE 0x498342
 
 #if HAVE_THREADS
+static int decode_tiles_mt(AVCodecContext *avctx, void *tdata, int jobnr,
+                           int threadnr);
+static int loopfilter_proc(AVCodecContext *avctx);
+
+static void tile_worker_func(void *priv, int jobnr, int threadnr,
+                             int nb_jobs, int nb_threads)
+{
+    decode_tiles_mt(priv, NULL, jobnr, threadnr);
+}
+
+static void tile_main_func(void *priv)
+{
+    loopfilter_proc(priv);
+}
+
+/*
+ * Under frame threading, each frame thread may additionally decode the
+ * tile columns of its frame in parallel, with as many threads as the
+ * tile_threads option allows. Returns the number of tile threads allowed.
+ */
+static int vp9_tile_thread_budget(AVCodecContext *avctx)
+{
+    VP9Context *s = avctx->priv_data;
+
+    if (avctx->active_thread_type != FF_THREAD_FRAME ||
+        !(avctx->thread_type & FF_THREAD_SLICE))
+        return 0;
+    return s->tile_threads;
+}
+
+static int vp9_use_tile_threads(AVCodecContext *avctx)
+{
+    VP9Context *s = avctx->priv_data;
+
+    return avctx->active_thread_type == FF_THREAD_SLICE || s->tile_thread;
+}
+
 static void vp9_free_entries(AVCodecContext *avctx) {
     VP9Context *s = avctx->priv_data;
 
-    if (avctx->active_thread_type & FF_THREAD_SLICE)  {
+    if (s->entries) {
         pthread_mutex_destroy(&s->progress_mutex);
         pthread_cond_destroy(&s->progress_cond);
         av_freep(&s->entries);
@@ -52,7 +91,7 @@ static int vp9_alloc_entries(AVCodecContext *avctx, int n) {
     VP9Context *s = avctx->priv_data;
     int i;
 
-    if (avctx->active_thread_type & FF_THREAD_SLICE)  {
+    if (vp9_use_tile_threads(avctx)) {
         if (s->entries)
             av_freep(&s->entries);
 
@@ -89,6 +128,8 @@ static void vp9_await_tile_progress(VP9Context *s, int field, int n) {
     pthread_mutex_unlock(&s->progress_mutex);
 }
 #else
+static int vp9_tile_thread_budget(AVCodecContext *avctx) { return 0; }
+static int vp9_use_tile_threads(AVCodecContext *avctx) { return 0; }
 static void vp9_free_entries(AVCodecContext *avctx) {}
 static int vp9_alloc_entries(AVCodecContext *avctx, int n) { return 0; }
 #endif
@@ -251,7 +292,8 @@ static int update_size(AVCodecContext *avctx, int w, int h)
     s->sb_rows   = (h + 63) >> 6;
     s->cols      = (w + 7) >> 3;
     s->rows      = (h + 7) >> 3;
-    lflvl_len    = avctx->active_thread_type == FF_THREAD_SLICE ? s->sb_rows : 1;
+    lflvl_len    = avctx->active_thread_type == FF_THREAD_SLICE ||
+                   vp9_tile_thread_budget(avctx) > 1 ? s->sb_rows : 1;
 
 #define assign(var, type, n) var = (type) p; p += s->sb_cols * (n) * sizeof(*var)
     av_freep(&s->intra_pred_data[0]);
@@ -782,11 +824,27 @@ static int decode_frame_header(AVCodecContext *avctx,
 
         s->s.h.tiling.tile_cols = 1 << s->s.h.tiling.log2_tile_cols;
         vp9_free_entries(avctx);
-        s->active_tile_cols = avctx->active_thread_type == FF_THREAD_SLICE ?
+#if HAVE_THREADS
+        avpriv_slicethread_free(&s->tile_thread);
+        if (s->s.h.tiling.tile_cols > 1) {
+            int nb_threads = FFMIN(s->s.h.tiling.tile_cols,
+                                   vp9_tile_thread_budget(avctx));
+            if (nb_threads > 1 &&
+                avpriv_slicethread_create(&s->tile_thread, avctx,
+                                          tile_worker_func, tile_main_func,
+                                          nb_threads) <= 1)
+                avpriv_slicethread_free(&s->tile_thread);
+        }
+#endif
+        s->active_tile_cols = vp9_use_tile_threads(avctx) ?
                               s->s.h.tiling.tile_cols : 1;
         vp9_alloc_entries(avctx, s->sb_rows);
         if (avctx->active_thread_type == FF_THREAD_SLICE) {
             n_range_coders = 4; // max_tile_rows
+        } else if (s->active_tile_cols > 1) {
+            // frames using two-pass decoding still go through
+            // decode_tiles(), which needs a range coder per tile column
+            n_range_coders = FFMAX(4, s->s.h.tiling.tile_cols);
         } else {
             n_range_coders = s->s.h.tiling.tile_cols;
         }
@@ -1232,6 +1290,9 @@ static av_cold int vp9_decode_free(AVCodecContext *avctx)
 
     free_buffers(s);
     vp9_free_entries(avctx);
+#if HAVE_THREADS
+    avpriv_slicethread_free(&s->tile_thread);
+#endif
     av_freep(&s->td);
     return 0;
 }
@@ -1370,9 +1431,8 @@ static int decode_tiles(AVCodecContext *avctx,
 }
 
 #if HAVE_THREADS
-static av_always_inline
-int decode_tiles_mt(AVCodecContext *avctx, void *tdata, int jobnr,
-                              int threadnr)
+static int decode_tiles_mt(AVCodecContext *avctx, void *tdata, int jobnr,
+                           int threadnr)
 {
     VP9Context *s = avctx->priv_data;
     VP9TileData *td = &s->td[jobnr];
@@ -1447,8 +1507,7 @@ int decode_tiles_mt(AVCodecContext *avctx, void *tdata, int jobnr,
     return 0;
 }
 
-static av_always_inline
-int loopfilter_proc(AVCodecContext *avctx)
+static int loopfilter_proc(AVCodecContext *avctx)
 {
     VP9Context *s = avctx->priv_data;
     ptrdiff_t uvoff, yoff, ls_y, ls_uv;
@@ -1474,6 +1533,10 @@ int loopfilter_proc(AVCodecContext *avctx)
                                      yoff, uvoff);
             }
         }
+
+        // lets frame threads waiting on this reference start early when
+        // tile threads run inside a frame thread
+        ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, i, 0);
     }
     return 0;
 }
@@ -1610,7 +1673,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
     }
 
 #if HAVE_THREADS
-    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+    if (vp9_use_tile_threads(avctx)) {
         for (i = 0; i < s->sb_rows; i++)
             atomic_store(&s->entries[i], 0);
     }
@@ -1628,11 +1691,9 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
 
 #if HAVE_THREADS
-        if (avctx->active_thread_type == FF_THREAD_SLICE) {
+        if (vp9_use_tile_threads(avctx) && !s->pass) {
             int tile_row, tile_col;
 
-            av_assert1(!s->pass);
-
             for (tile_row = 0; tile_row < s->s.h.tiling.tile_rows; tile_row++) {
                 for (tile_col = 0; tile_col < s->s.h.tiling.tile_cols; tile_col++) {
                     int64_t tile_size;
@@ -1646,18 +1707,25 @@ FF_ENABLE_DEPRECATION_WARNINGS
                         size -= 4;
                     }
                     if (tile_size > size)
-                        return AVERROR_INVALIDDATA;
-                    ret = ff_vp56_init_range_decoder(&s->td[tile_col].c_b[tile_row], data, tile_size);
-                    if (ret < 0)
+                        ret = AVERROR_INVALIDDATA;
+                    else
+                        ret = ff_vp56_init_range_decoder(&s->td[tile_col].c_b[tile_row], data, tile_size);
+                    if (ret >= 0 &&
+                        vp56_rac_get_prob_branchy(&s->td[tile_col].c_b[tile_row], 128)) // marker bit
+                        ret = AVERROR_INVALIDDATA;
+                    if (ret < 0) {
+                        ff_thread_report_progress(&s->s.frames[CUR_FRAME].tf, INT_MAX, 0);
                         return ret;
-                    if (vp56_rac_get_prob_branchy(&s->td[tile_col].c_b[tile_row], 128)) // marker bit
-                        return AVERROR_INVALIDDATA;
+                    }
                     data += tile_size;
                     size -= tile_size;
                 }
             }
 
-            ff_slice_thread_execute_with_mainfunc(avctx, decode_tiles_mt, loopfilter_proc, s->td, NULL, s->s.h.tiling.tile_cols);
+            if (s->tile_thread)
+                avpriv_slicethread_execute(s->tile_thread, s->s.h.tiling.tile_cols, 1);
+            else
+                ff_slice_thread_execute_with_mainfunc(avctx, decode_tiles_mt, loopfilter_proc, s->td, NULL, s->s.h.tiling.tile_cols);
         } else
 #endif
         {
@@ -1669,7 +1737,7 @@ FF_ENABLE_DEPRECATION_WARNINGS
         }
 
         // Sum all counts fields into td[0].counts for tile threading
-        if (avctx->active_thread_type == FF_THREAD_SLICE)
+        if (vp9_use_tile_threads(avctx) && !s->pass)
             for (i = 1; i < s->s.h.tiling.tile_cols; i++)
                 for (j = 0; j < sizeof(s->td[i].counts) / sizeof(unsigned); j++)
                     ((unsigned *)&s->td[0].counts)[j] += ((unsigned *)&s->td[i].counts)[j];
@@ -1800,12 +1868,29 @@ static int vp9_decode_update_thread_context(AVCodecContext *dst, const AVCodecCo
 }
 #endif
 
+#define OFFSET(x) offsetof(VP9Context, x)
+#define PAR (AV_OPT_FLAG_DECODING_PARAM | AV_OPT_FLAG_VIDEO_PARAM)
+
+static const AVOption options[] = {
+    { "tile_threads", "Number of threads decoding the tile columns of each frame thread",
+        OFFSET(tile_threads), AV_OPT_TYPE_INT, {.i64 = 1}, 1, 64, PAR },
+    { NULL },
+};
+
+static const AVClass vp9_decoder_class = {
+    .class_name = "VP9 decoder",
+    .item_name  = av_default_item_name,
+    .option     = options,
+    .version    = LIBAVUTIL_VERSION_INT,
+};
+
 AVCodec ff_vp9_decoder = {
     .name                  = "vp9",
     .long_name             = NULL_IF_CONFIG_SMALL("Google VP9"),
     .type                  = AVMEDIA_TYPE_VIDEO,
     .id                    = AV_CODEC_ID_VP9,
     .priv_data_size        = sizeof(VP9Context),
+    .priv_class            = &vp9_decoder_class,
     .init                  = vp9_decode_init,
     .close                 = vp9_decode_free,
     .decode                = vp9_decode_frame,
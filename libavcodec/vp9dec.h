@@ -102,7 +102,10 @@ typedef struct VP9Context {
     pthread_mutex_t progress_mutex;
     pthread_cond_t progress_cond;
     atomic_int *entries;
+    // tile workers of this frame thread, only used under frame threading
+    struct AVSliceThread *tile_thread;
 #endif
+    int tile_threads;
 
     uint8_t ss_h, ss_v;
     uint8_t last_bpp, bpp_index, bytesperpixel;
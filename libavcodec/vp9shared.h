@@ -157,6 +157,7 @@ typedef struct VP9BitstreamHeader {
 } VP9BitstreamHeader;
 
 typedef struct VP9SharedContext {
+    const AVClass *class;   ///< class of the vp9 decoder options, must be first
     VP9BitstreamHeader h;
 
     ThreadFrame refs[8];
@@ -26,6 +26,7 @@
 #include "libavutil/opt.h"
 #include "libavcodec/avfft.h"
 
+#include "af_afirdsp.h"
 #include "audio.h"
 #include "avfilter.h"
 #include "formats.h"
@@ -53,11 +54,6 @@ typedef struct AudioFIRSegment {
     RDFTContext **rdft, **irdft;
 } AudioFIRSegment;
 
-typedef struct AudioFIRDSPContext {
-    void (*fcmul_add)(float *sum, const float *t, const float *c,
-                      ptrdiff_t len);
-} AudioFIRDSPContext;
-
 typedef struct AudioFIRContext {
     const AVClass *class;
 
@@ -100,7 +96,4 @@ typedef struct AudioFIRContext {
 
 } AudioFIRContext;
 
-void ff_afir_init(AudioFIRDSPContext *s);
-void ff_afir_init_x86(AudioFIRDSPContext *s);
-
 #endif /* AVFILTER_AFIR_H */
@@ -49,6 +49,7 @@ typedef struct IIRChannel {
     double *ab[2];
     double g;
     double *cache[2];
+    int cache_pos[2];
     BiquadContext *biquads;
     int clippings;
 } IIRChannel;
@@ -73,6 +74,7 @@ typedef struct AudioIIRContext {
     enum AVSampleFormat sample_format;
 
     int (*iir_channel)(AVFilterContext *ctx, void *arg, int ch, int nb_jobs);
+    void (*iir_channel_pair)(AVFilterContext *ctx, void *arg, int ch);
 } AudioIIRContext;
 
 static int query_formats(AVFilterContext *ctx)
@@ -131,6 +133,8 @@ static int iir_ch_## name(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)
     const type *src = (const type *)in->extended_data[ch];              \
     double *ic = (double *)s->iir[ch].cache[0];                         \
     double *oc = (double *)s->iir[ch].cache[1];                         \
+    int ipos = s->iir[ch].cache_pos[0];                                 \
+    int opos = s->iir[ch].cache_pos[1];                                 \
     const int nb_a = s->iir[ch].nb_ab[0];                               \
     const int nb_b = s->iir[ch].nb_ab[1];                               \
     const double *a = s->iir[ch].ab[0];                                 \
@@ -144,18 +148,18 @@ static int iir_ch_## name(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)
         double sample = 0.;                                             \
         int x;                                                          \
                                                                         \
-        memmove(&ic[1], &ic[0], (nb_b - 1) * sizeof(*ic));              \
-        memmove(&oc[1], &oc[0], (nb_a - 1) * sizeof(*oc));              \
-        ic[0] = src[n] * ig;                                            \
+        ipos = ipos ? ipos - 1 : nb_b - 1;                              \
+        opos = opos ? opos - 1 : nb_a - 1;                              \
+        ic[ipos] = ic[ipos + nb_b] = src[n] * ig;                       \
         for (x = 0; x < nb_b; x++)                                      \
-            sample += b[x] * ic[x];                                     \
+            sample += b[x] * ic[ipos + x];                              \
                                                                         \
         for (x = 1; x < nb_a; x++)                                      \
-            sample -= a[x] * oc[x];                                     \
+            sample -= a[x] * oc[opos + x];                              \
                                                                         \
-        oc[0] = sample;                                                 \
+        oc[opos] = oc[opos + nb_a] = sample;                            \
         sample *= og * g;                                               \
-        sample = sample * mix + ic[0] * (1. - mix);                     \
+        sample = sample * mix + ic[ipos] * (1. - mix);                  \
         if (need_clipping && sample < min) {                            \
             (*clippings)++;                                             \
             dst[n] = min;                                               \
@@ -167,6 +171,9 @@ static int iir_ch_## name(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)
         }                                                               \
     }                                                                   \
                                                                         \
+    s->iir[ch].cache_pos[0] = ipos;                                     \
+    s->iir[ch].cache_pos[1] = opos;                                     \
+                                                                        \
     return 0;                                                           \
 }
 
@@ -175,62 +182,163 @@ IIR_CH(s32p, int32_t, INT32_MIN, INT32_MAX, 1)
 IIR_CH(fltp, float,         -1.,        1., 0)
 IIR_CH(dblp, double,        -1.,        1., 0)
 
-#define SERIAL_IIR_CH(name, type, min, max, need_clipping)                  \
-static int iir_ch_serial_## name(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)  \
+#define IIR_STORE(dst, sample, clippings, min, max, need_clipping)      \
+    if (need_clipping && sample < min) {                                \
+        (*clippings)++;                                                 \
+        dst = min;                                                      \
+    } else if (need_clipping && sample > max) {                         \
+        (*clippings)++;                                                 \
+        dst = max;                                                      \
+    } else {                                                            \
+        dst = sample;                                                   \
+    }
+
+#define SERIAL_IIR_CH(name, type, min, max, need_clipping)              \
+static void serial_biquad_## name(AudioIIRContext *s, BiquadContext *bq, \
+                                  double g, const type *src, type *dst, \
+                                  int nb_samples, int stage,            \
+                                  int *clippings)                       \
+{                                                                       \
+    const double ig = s->dry_gain;                                      \
+    const double og = s->wet_gain;                                      \
+    const double mix = s->mix;                                          \
+    const double a1 = -bq->a[1];                                        \
+    const double a2 = -bq->a[2];                                        \
+    const double b0 = bq->b[0];                                         \
+    const double b1 = bq->b[1];                                         \
+    const double b2 = bq->b[2];                                         \
+    double i1 = bq->i1;                                                 \
+    double i2 = bq->i2;                                                 \
+    double o1 = bq->o1;                                                 \
+    double o2 = bq->o2;                                                 \
+    int n;                                                              \
+                                                                        \
+    for (n = 0; n < nb_samples; n++) {                                  \
+        double sample = ig * (stage ? dst[n] : src[n]);                 \
+        double o0 = sample * b0 + i1 * b1 + i2 * b2 + o1 * a1 + o2 * a2; \
+                                                                        \
+        i2 = i1;                                                        \
+        i1 = src[n];                                                    \
+        o2 = o1;                                                        \
+        o1 = o0;                                                        \
+        o0 *= og * g;                                                   \
+                                                                        \
+        o0 = o0 * mix + (1. - mix) * sample;                            \
+        IIR_STORE(dst[n], o0, clippings, min, max, need_clipping)       \
+    }                                                                   \
+    bq->i1 = i1;                                                        \
+    bq->i2 = i2;                                                        \
+    bq->o1 = o1;                                                        \
+    bq->o2 = o2;                                                        \
+}                                                                       \
+                                                                        \
+static void serial_biquad_pair_## name(AudioIIRContext *s,              \
+                                       BiquadContext **bq,              \
+                                       const double *g,                 \
+                                       const type **src, type **dst,    \
+                                       int nb_samples, int stage,       \
+                                       int **clippings)                 \
 {                                                                       \
-    AudioIIRContext *s = ctx->priv;                                     \
     const double ig = s->dry_gain;                                      \
     const double og = s->wet_gain;                                      \
     const double mix = s->mix;                                          \
+    double a1[2], a2[2], b0[2], b1[2], b2[2];                           \
+    double i1[2], i2[2], o1[2], o2[2];                                  \
+    int n, c;                                                           \
+                                                                        \
+    for (c = 0; c < 2; c++) {                                           \
+        a1[c] = -bq[c]->a[1];                                           \
+        a2[c] = -bq[c]->a[2];                                           \
+        b0[c] =  bq[c]->b[0];                                           \
+        b1[c] =  bq[c]->b[1];                                           \
+        b2[c] =  bq[c]->b[2];                                           \
+        i1[c] =  bq[c]->i1;                                             \
+        i2[c] =  bq[c]->i2;                                             \
+        o1[c] =  bq[c]->o1;                                             \
+        o2[c] =  bq[c]->o2;                                             \
+    }                                                                   \
+                                                                        \
+    for (n = 0; n < nb_samples; n++) {                                  \
+        for (c = 0; c < 2; c++) {                                       \
+            double sample = ig * (stage ? dst[c][n] : src[c][n]);       \
+            double o0 = sample * b0[c] + i1[c] * b1[c] + i2[c] * b2[c] + \
+                        o1[c] * a1[c] + o2[c] * a2[c];                  \
+                                                                        \
+            i2[c] = i1[c];                                              \
+            i1[c] = src[c][n];                                          \
+            o2[c] = o1[c];                                              \
+            o1[c] = o0;                                                 \
+            o0 *= og * g[c];                                            \
+                                                                        \
+            o0 = o0 * mix + (1. - mix) * sample;                        \
+            IIR_STORE(dst[c][n], o0, clippings[c], min, max, need_clipping) \
+        }                                                               \
+    }                                                                   \
+                                                                        \
+    for (c = 0; c < 2; c++) {                                           \
+        bq[c]->i1 = i1[c];                                              \
+        bq[c]->i2 = i2[c];                                              \
+        bq[c]->o1 = o1[c];                                              \
+        bq[c]->o2 = o2[c];                                              \
+    }                                                                   \
+}                                                                       \
+                                                                        \
+static int iir_ch_serial_## name(AVFilterContext *ctx, void *arg, int ch, int nb_jobs)  \
+{                                                                       \
+    AudioIIRContext *s = ctx->priv;                                     \
     ThreadData *td = arg;                                               \
     AVFrame *in = td->in, *out = td->out;                               \
-    const type *src = (const type *)in->extended_data[ch];              \
-    type *dst = (type *)out->extended_data[ch];                         \
     IIRChannel *iir = &s->iir[ch];                                      \
-    const double g = iir->g;                                            \
-    int *clippings = &iir->clippings;                                   \
     int nb_biquads = (FFMAX(iir->nb_ab[0], iir->nb_ab[1]) + 1) / 2;     \
-    int n, i;                                                           \
+    int i;                                                              \
                                                                         \
-    for (i = 0; i < nb_biquads; i++) {                                  \
-        const double a1 = -iir->biquads[i].a[1];                        \
-        const double a2 = -iir->biquads[i].a[2];                        \
-        const double b0 = iir->biquads[i].b[0];                         \
-        const double b1 = iir->biquads[i].b[1];                         \
-        const double b2 = iir->biquads[i].b[2];                         \
-        double i1 = iir->biquads[i].i1;                                 \
-        double i2 = iir->biquads[i].i2;                                 \
-        double o1 = iir->biquads[i].o1;                                 \
-        double o2 = iir->biquads[i].o2;                                 \
+    for (i = 0; i < nb_biquads; i++)                                    \
+        serial_biquad_## name(s, &iir->biquads[i], iir->g,              \
+                              (const type *)in->extended_data[ch],      \
+                              (type *)out->extended_data[ch],           \
+                              in->nb_samples, i, &iir->clippings);      \
                                                                         \
-        for (n = 0; n < in->nb_samples; n++) {                          \
-            double sample = ig * (i ? dst[n] : src[n]);                 \
-            double o0 = sample * b0 + i1 * b1 + i2 * b2 + o1 * a1 + o2 * a2; \
+    return 0;                                                           \
+}                                                                       \
                                                                         \
-            i2 = i1;                                                    \
-            i1 = src[n];                                                \
-            o2 = o1;                                                    \
-            o1 = o0;                                                    \
-            o0 *= og * g;                                               \
+static void iir_ch_serial_pair_## name(AVFilterContext *ctx, void *arg, int ch) \
+{                                                                       \
+    AudioIIRContext *s = ctx->priv;                                     \
+    ThreadData *td = arg;                                               \
+    AVFrame *in = td->in, *out = td->out;                               \
+    BiquadContext *bq[2];                                               \
+    const type *src[2];                                                 \
+    type *dst[2];                                                       \
+    double g[2];                                                        \
+    int *clippings[2];                                                  \
+    int nb_biquads[2];                                                  \
+    int i, c;                                                           \
                                                                         \
-            o0 = o0 * mix + (1. - mix) * sample;                        \
-            if (need_clipping && o0 < min) {                            \
-                (*clippings)++;                                         \
-                dst[n] = min;                                           \
-            } else if (need_clipping && o0 > max) {                     \
-                (*clippings)++;                                         \
-                dst[n] = max;                                           \
-            } else {                                                    \
-                dst[n] = o0;                                            \
-            }                                                           \
-        }                                                               \
-        iir->biquads[i].i1 = i1;                                        \
-        iir->biquads[i].i2 = i2;                                        \
-        iir->biquads[i].o1 = o1;                                        \
-        iir->biquads[i].o2 = o2;                                        \
+    for (c = 0; c < 2; c++) {                                           \
+        IIRChannel *iir = &s->iir[ch + c];                              \
+                                                                        \
+        src[c] = (const type *)in->extended_data[ch + c];               \
+        dst[c] = (type *)out->extended_data[ch + c];                    \
+        g[c] = iir->g;                                                  \
+        clippings[c] = &iir->clippings;                                 \
+        nb_biquads[c] = (FFMAX(iir->nb_ab[0], iir->nb_ab[1]) + 1) / 2;  \
     }                                                                   \
                                                                         \
-    return 0;                                                           \
+    for (i = 0; i < FFMIN(nb_biquads[0], nb_biquads[1]); i++) {         \
+        bq[0] = &s->iir[ch    ].biquads[i];                             \
+        bq[1] = &s->iir[ch + 1].biquads[i];                             \
+        serial_biquad_pair_## name(s, bq, g, src, dst,                  \
+                                   in->nb_samples, i, clippings);       \
+    }                                                                   \
+                                                                        \
+    for (c = 0; c < 2; c++) {                                           \
+        IIRChannel *iir = &s->iir[ch + c];                              \
+                                                                        \
+        for (i = FFMIN(nb_biquads[0], nb_biquads[1]); i < nb_biquads[c]; i++) \
+            serial_biquad_## name(s, &iir->biquads[i], g[c], src[c],    \
+                                  dst[c], in->nb_samples, i,            \
+                                  clippings[c]);                        \
+    }                                                                   \
 }
 
 SERIAL_IIR_CH(s16p, int16_t, INT16_MIN, INT16_MAX, 1)
@@ -238,6 +346,30 @@ SERIAL_IIR_CH(s32p, int32_t, INT32_MIN, INT32_MAX, 1)
 SERIAL_IIR_CH(fltp, float,         -1.,        1., 0)
 SERIAL_IIR_CH(dblp, double,        -1.,        1., 0)
 
+/*
+ * Channels are handed out to the threads in slices. For serial cascading
+ * each section is applied to two neighbouring channels at once, their
+ * sections being independent; the output is identical to filtering the
+ * channels one after another.
+ */
+static int iir_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    AudioIIRContext *s = ctx->priv;
+    const int start = (s->channels * jobnr) / nb_jobs;
+    const int end = (s->channels * (jobnr+1)) / nb_jobs;
+    int ch = start;
+
+    if (s->iir_channel_pair) {
+        for (; ch + 1 < end; ch += 2)
+            s->iir_channel_pair(ctx, arg, ch);
+    }
+
+    for (; ch < end; ch++)
+        s->iir_channel(ctx, arg, ch, nb_jobs);
+
+    return 0;
+}
+
 static void count_coefficients(char *item_str, int *nb_items)
 {
     char *p;
@@ -360,7 +492,8 @@ static int read_channels(AVFilterContext *ctx, int channels, uint8_t *item_str,
         count_coefficients(arg, &iir->nb_ab[ab]);
 
         p = NULL;
-        iir->cache[ab] = av_calloc(iir->nb_ab[ab] + 1, sizeof(double));
+        /* the delay line is stored twice, so the taps are always contiguous */
+        iir->cache[ab] = av_calloc(2 * (iir->nb_ab[ab] + 1), sizeof(double));
         iir->ab[ab] = av_calloc(iir->nb_ab[ab] * (!!s->format + 1), sizeof(double));
         if (!iir->ab[ab] || !iir->cache[ab]) {
             av_freep(&old_str);
@@ -994,6 +1127,16 @@ static int config_output(AVFilterLink *outlink)
     case AV_SAMPLE_FMT_S16P: s->iir_channel = s->process == 1 ? iir_ch_serial_s16p : iir_ch_s16p; break;
     }
 
+    s->iir_channel_pair = NULL;
+    if (s->process == 1) {
+        switch (inlink->format) {
+        case AV_SAMPLE_FMT_DBLP: s->iir_channel_pair = iir_ch_serial_pair_dblp; break;
+        case AV_SAMPLE_FMT_FLTP: s->iir_channel_pair = iir_ch_serial_pair_fltp; break;
+        case AV_SAMPLE_FMT_S32P: s->iir_channel_pair = iir_ch_serial_pair_s32p; break;
+        case AV_SAMPLE_FMT_S16P: s->iir_channel_pair = iir_ch_serial_pair_s16p; break;
+        }
+    }
+
     return 0;
 }
 
@@ -1019,7 +1162,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 
     td.in  = in;
     td.out = out;
-    ctx->internal->execute(ctx, s->iir_channel, &td, NULL, outlink->channels);
+    ctx->internal->execute(ctx, iir_channels, &td, NULL, FFMIN(outlink->channels, ff_filter_get_nb_threads(ctx)));
 
     for (ch = 0; ch < outlink->channels; ch++) {
         if (s->iir[ch].clippings > 0)
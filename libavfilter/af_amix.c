@@ -52,6 +52,10 @@
 #define DURATION_SHORTEST 1
 #define DURATION_FIRST    2
 
+/* number of samples per plane mixed from all inputs before moving on, so
+ * that the output block stays in cache whatever the number of inputs */
+#define MIX_BLOCK_SIZE 1024
+
 
 typedef struct FrameInfo {
     int nb_samples;
@@ -168,6 +172,9 @@ typedef struct MixContext {
     int sample_rate;            /**< sample rate */
     int planar;
     AVAudioFifo **fifos;        /**< audio fifo for each input */
+    AVFrame **pending;          /**< frame of each input not copied to its fifo */
+    AVFrame **mix_frames;       /**< input frames being mixed */
+    float *mix_scales;          /**< scale factors of the frames being mixed */
     uint8_t *input_state;       /**< current state of each input */
     float *input_scale;         /**< mixing scale factor for each input */
     float *weights;             /**< custom weights for every input */
@@ -249,7 +256,10 @@ static int config_output(AVFilterLink *outlink)
         return AVERROR(ENOMEM);
 
     s->fifos = av_mallocz_array(s->nb_inputs, sizeof(*s->fifos));
-    if (!s->fifos)
+    s->pending    = av_mallocz_array(s->nb_inputs, sizeof(*s->pending));
+    s->mix_frames = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_frames));
+    s->mix_scales = av_mallocz_array(s->nb_inputs, sizeof(*s->mix_scales));
+    if (!s->fifos || !s->pending || !s->mix_frames || !s->mix_scales)
         return AVERROR(ENOMEM);
 
     s->nb_channels = outlink->channels;
@@ -282,6 +292,140 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+/**
+ * Get the number of samples buffered for an input.
+ */
+static int input_samples(MixContext *s, int i)
+{
+    return av_audio_fifo_size(s->fifos[i]) +
+           (s->pending[i] ? s->pending[i]->nb_samples : 0);
+}
+
+/**
+ * Move the pending frame of an input, if any, to its FIFO.
+ */
+static int flush_pending(MixContext *s, int i)
+{
+    AVFrame *frame = s->pending[i];
+    int ret;
+
+    if (!frame)
+        return 0;
+    s->pending[i] = NULL;
+    ret = av_audio_fifo_write(s->fifos[i], (void **)frame->extended_data,
+                              frame->nb_samples);
+    av_frame_free(&frame);
+    return ret < 0 ? ret : 0;
+}
+
+/**
+ * Check whether an input frame can be mixed in place, i.e. it is as aligned
+ * and padded as a buffer from ff_get_audio_buffer() would be.
+ */
+static int frame_is_mixable(MixContext *s, const AVFrame *frame)
+{
+    int planes     = s->planar ? s->nb_channels : 1;
+    int plane_size = frame->nb_samples * (s->planar ? 1 : s->nb_channels);
+    int p;
+
+    plane_size = FFALIGN(plane_size, 16) * av_get_bytes_per_sample(frame->format);
+    if (frame->linesize[0] < plane_size)
+        return 0;
+    for (p = 0; p < planes; p++)
+        if ((uintptr_t)frame->extended_data[p] & 31)
+            return 0;
+    return 1;
+}
+
+/**
+ * Queue an input frame. While an input keeps up with the first one and its
+ * frames are aligned with the output frames, they are mixed directly instead
+ * of going through the FIFO.
+ */
+static int queue_frame(MixContext *s, int i, AVFrame *frame)
+{
+    int ret;
+
+    if (!s->pending[i] && !av_audio_fifo_size(s->fifos[i]) &&
+        frame_is_mixable(s, frame)) {
+        s->pending[i] = frame;
+        return 0;
+    }
+
+    ret = flush_pending(s, i);
+    if (ret >= 0)
+        ret = av_audio_fifo_write(s->fifos[i], (void **)frame->extended_data,
+                                  frame->nb_samples);
+    av_frame_free(&frame);
+    return ret < 0 ? ret : 0;
+}
+
+/**
+ * Get nb_samples samples of an input, either as its pending frame or read
+ * from its FIFO into a new buffer.
+ */
+static int get_input_frame(AVFilterLink *outlink, int i, int nb_samples,
+                           AVFrame **frame)
+{
+    MixContext *s = outlink->src->priv;
+    int ret;
+
+    if (s->pending[i] && !av_audio_fifo_size(s->fifos[i]) &&
+        s->pending[i]->nb_samples == nb_samples) {
+        *frame = s->pending[i];
+        s->pending[i] = NULL;
+        return 0;
+    }
+
+    ret = flush_pending(s, i);
+    if (ret < 0)
+        return ret;
+
+    *frame = ff_get_audio_buffer(outlink, nb_samples);
+    if (!*frame)
+        return AVERROR(ENOMEM);
+    av_audio_fifo_read(s->fifos[i], (void **)(*frame)->extended_data,
+                       nb_samples);
+    return 0;
+}
+
+/**
+ * Mix all the input frames in one pass over the output, block by block.
+ */
+static void mix_frames(MixContext *s, AVFrame *out, int nb_frames, int nb_samples)
+{
+    AVFrame **in  = s->mix_frames;
+    float *scales = s->mix_scales;
+    int planes     = s->planar ? s->nb_channels : 1;
+    int plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
+    int p, i, j;
+
+    plane_size = FFALIGN(plane_size, 16);
+
+    for (p = 0; p < planes; p++) {
+        for (i = 0; i < plane_size; i += MIX_BLOCK_SIZE) {
+            int len = FFMIN(MIX_BLOCK_SIZE, plane_size - i);
+
+            if (out->format == AV_SAMPLE_FMT_FLT ||
+                out->format == AV_SAMPLE_FMT_FLTP) {
+                float *dst = (float *)out->extended_data[p] + i;
+
+                for (j = 0; j < nb_frames; j++)
+                    s->fdsp->vector_fmac_scalar(dst,
+                                                (float *)in[j]->extended_data[p] + i,
+                                                scales[j], len);
+            } else {
+                double *dst = (double *)out->extended_data[p] + i;
+
+                for (j = 0; j < nb_frames; j++)
+                    s->fdsp->vector_dmac_scalar(dst,
+                                                (double *)in[j]->extended_data[p] + i,
+                                                scales[j], len);
+            }
+        }
+    }
+}
+
 /**
  * Read samples from the input FIFOs, mix, and write to the output link.
  */
@@ -289,15 +433,15 @@ static int output_frame(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, i;
+    AVFrame *out_buf;
+    int nb_samples, nb_frames, ns, i, ret = 0;
 
     if (s->input_state[0] & INPUT_ON) {
         /* first input live: use the corresponding frame size */
         nb_samples = frame_list_next_frame_size(s->frame_list);
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_samples(s, i);
                 if (ns < nb_samples) {
                     if (!(s->input_state[i] & INPUT_EOF))
                         /* unclosed input with not enough samples */
@@ -312,7 +456,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = INT_MAX;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_samples(s, i);
                 nb_samples = FFMIN(nb_samples, ns);
             }
         }
@@ -334,40 +478,24 @@ static int output_frame(AVFilterLink *outlink)
     if (!out_buf)
         return AVERROR(ENOMEM);
 
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
-        av_frame_free(&out_buf);
-        return AVERROR(ENOMEM);
-    }
-
+    nb_frames = 0;
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
-
-            av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
-                               nb_samples);
-
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
-
-            if (out_buf->format == AV_SAMPLE_FMT_FLT ||
-                out_buf->format == AV_SAMPLE_FMT_FLTP) {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                                (float *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            } else {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_dmac_scalar((double *)out_buf->extended_data[p],
-                                                (double *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
-            }
+            ret = get_input_frame(outlink, i, nb_samples, &s->mix_frames[nb_frames]);
+            if (ret < 0)
+                break;
+            s->mix_scales[nb_frames++] = s->input_scale[i];
         }
     }
-    av_frame_free(&in_buf);
+
+    if (ret >= 0)
+        mix_frames(s, out_buf, nb_frames, nb_samples);
+    for (i = 0; i < nb_frames; i++)
+        av_frame_free(&s->mix_frames[i]);
+    if (ret < 0) {
+        av_frame_free(&out_buf);
+        return ret;
+    }
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
@@ -390,7 +518,7 @@ static int request_samples(AVFilterContext *ctx, int min_samples)
         if (!(s->input_state[i] & INPUT_ON) ||
              (s->input_state[i] & INPUT_EOF))
             continue;
-        if (av_audio_fifo_size(s->fifos[i]) >= min_samples)
+        if (input_samples(s, i) >= min_samples)
             continue;
         ff_inlink_request_frame(ctx->inputs[i]);
     }
@@ -441,14 +569,9 @@ static int activate(AVFilterContext *ctx)
                 }
             }
 
-            ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
-                                      buf->nb_samples);
-            if (ret < 0) {
-                av_frame_free(&buf);
+            ret = queue_frame(s, i, buf);
+            if (ret < 0)
                 return ret;
-            }
-
-            av_frame_free(&buf);
 
             ret = output_frame(outlink);
             if (ret < 0)
@@ -470,7 +593,7 @@ static int activate(AVFilterContext *ctx)
                     }
                 } else {
                     s->input_state[i] |= INPUT_EOF;
-                    if (av_audio_fifo_size(s->fifos[i]) == 0) {
+                    if (input_samples(s, i) == 0) {
                         s->input_state[i] = 0;
                     }
                 }
@@ -561,6 +684,13 @@ static av_cold void uninit(AVFilterContext *ctx)
             av_audio_fifo_free(s->fifos[i]);
         av_freep(&s->fifos);
     }
+    if (s->pending) {
+        for (i = 0; i < s->nb_inputs; i++)
+            av_frame_free(&s->pending[i]);
+        av_freep(&s->pending);
+    }
+    av_freep(&s->mix_frames);
+    av_freep(&s->mix_scales);
     frame_list_clear(s->frame_list);
     av_freep(&s->frame_list);
     av_freep(&s->input_state);
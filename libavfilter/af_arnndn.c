@@ -254,6 +254,24 @@ static RNNModel *rnnoise_model_from_file(FILE *f)
     } \
     } while (0)
 
+#define INPUT_ARRAY2(name, len0, len1) do { \
+    float *values = av_calloc(FFALIGN((len0), 4) * (len1), sizeof(float)); \
+    if (!values) { \
+        rnnoise_model_free(ret); \
+        return NULL; \
+    } \
+    name = values; \
+    for (int k = 0; k < (len0); k++) { \
+        for (int i = 0; i < (len1); i++) { \
+            if (fscanf(f, "%d", &in) != 1) { \
+                rnnoise_model_free(ret); \
+                return NULL; \
+            } \
+            values[i * FFALIGN((len0), 4) + k] = in; \
+        } \
+    } \
+    } while (0)
+
 #define INPUT_ARRAY3(name, len0, len1, len2) do { \
     float *values = av_calloc(FFALIGN((len0), 4) * FFALIGN((len1), 4) * (len2), sizeof(float)); \
     if (!values) { \
@@ -279,7 +297,7 @@ static RNNModel *rnnoise_model_from_file(FILE *f)
     INPUT_VAL(name->nb_neurons); \
     ret->name ## _size = name->nb_neurons; \
     INPUT_ACTIVATION(name->activation); \
-    INPUT_ARRAY(name->input_weights, name->nb_inputs * name->nb_neurons); \
+    INPUT_ARRAY2(name->input_weights, name->nb_inputs, name->nb_neurons); \
     INPUT_ARRAY(name->bias, name->nb_neurons); \
     } while (0)
 
@@ -1232,17 +1250,16 @@ static inline float sigmoid_approx(float x)
     return .5f + .5f*tansig_approx(.5f*x);
 }
 
-static void compute_dense(const DenseLayer *layer, float *output, const float *input)
+static void compute_dense(AudioRNNContext *s, const DenseLayer *layer, float *output, const float *input)
 {
-    const int N = layer->nb_neurons, M = layer->nb_inputs, stride = N;
+    const int N = layer->nb_neurons, M = layer->nb_inputs;
+    const int AM = FFALIGN(M, 4), stride = AM;
 
     for (int i = 0; i < N; i++) {
         /* Compute update gate. */
         float sum = layer->bias[i];
 
-        for (int j = 0; j < M; j++)
-            sum += layer->input_weights[j * stride + i] * input[j];
-
+        sum += s->fdsp->scalarproduct_float(layer->input_weights + i * stride, input, AM);
         output[i] = WEIGHTS_SCALE * sum;
     }
 
@@ -1265,6 +1282,7 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
     LOCAL_ALIGNED_32(float, z, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, r, [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, h, [MAX_NEURONS]);
+    LOCAL_ALIGNED_32(float, rs, [MAX_NEURONS]);
     const int M = gru->nb_inputs;
     const int N = gru->nb_neurons;
     const int AN = FFALIGN(N, 4);
@@ -1289,13 +1307,17 @@ static void compute_gru(AudioRNNContext *s, const GRULayer *gru, float *state, c
         r[i] = sigmoid_approx(WEIGHTS_SCALE * sum);
     }
 
+    for (int i = 0; i < N; i++)
+        rs[i] = state[i] * r[i];
+    for (int i = N; i < AN; i++)
+        rs[i] = 0.f;
+
     for (int i = 0; i < N; i++) {
         /* Compute output. */
         float sum = gru->bias[2 * N + i];
 
         sum += s->fdsp->scalarproduct_float(gru->input_weights + 2 * AM + i * istride, input, AM);
-        for (int j = 0; j < N; j++)
-            sum += gru->recurrent_weights[2 * AN + i * stride + j] * state[j] * r[j];
+        sum += s->fdsp->scalarproduct_float(gru->recurrent_weights + 2 * AN + i * stride, rs, AN);
 
         if (gru->activation == ACTIVATION_SIGMOID)
             sum = sigmoid_approx(WEIGHTS_SCALE * sum);
@@ -1318,10 +1340,18 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
     LOCAL_ALIGNED_32(float, dense_out,     [MAX_NEURONS]);
     LOCAL_ALIGNED_32(float, noise_input,   [MAX_NEURONS * 3]);
     LOCAL_ALIGNED_32(float, denoise_input, [MAX_NEURONS * 3]);
+    const int dense_size   = rnn->model->input_dense_size;
+    const int noise_size   = rnn->model->input_dense_size + rnn->model->vad_gru_size + INPUT_SIZE;
+    const int denoise_size = rnn->model->vad_gru_size + rnn->model->noise_gru_size + INPUT_SIZE;
 
-    compute_dense(rnn->model->input_dense, dense_out, input);
+    /* the layers read their inputs up to the next multiple of 4 */
+    memset(dense_out + dense_size, 0, sizeof(*dense_out) * (FFALIGN(dense_size, 4) - dense_size));
+    memset(noise_input + noise_size, 0, sizeof(*noise_input) * (FFALIGN(noise_size, 4) - noise_size));
+    memset(denoise_input + denoise_size, 0, sizeof(*denoise_input) * (FFALIGN(denoise_size, 4) - denoise_size));
+
+    compute_dense(s, rnn->model->input_dense, dense_out, input);
     compute_gru(s, rnn->model->vad_gru, rnn->vad_gru_state, dense_out);
-    compute_dense(rnn->model->vad_output, vad, rnn->vad_gru_state);
+    compute_dense(s, rnn->model->vad_output, vad, rnn->vad_gru_state);
 
     for (int i = 0; i < rnn->model->input_dense_size; i++)
         noise_input[i] = dense_out[i];
@@ -1340,7 +1370,7 @@ static void compute_rnn(AudioRNNContext *s, RNNState *rnn, float *gains, float *
         denoise_input[i + rnn->model->vad_gru_size + rnn->model->noise_gru_size] = input[i];
 
     compute_gru(s, rnn->model->denoise_gru, rnn->denoise_gru_state, denoise_input);
-    compute_dense(rnn->model->denoise_output, gains, rnn->denoise_gru_state);
+    compute_dense(s, rnn->model->denoise_output, gains, rnn->denoise_gru_state);
 }
 
 static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, const float *in)
@@ -1350,7 +1380,7 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     float x[FRAME_SIZE];
     float Ex[NB_BANDS], Ep[NB_BANDS];
     float Exp[NB_BANDS];
-    float features[NB_FEATURES];
+    LOCAL_ALIGNED_32(float, features, [FFALIGN(NB_FEATURES, 4)]);
     float g[NB_BANDS];
     float gf[FREQ_SIZE];
     float vad_prob = 0;
@@ -1358,6 +1388,9 @@ static float rnnoise_channel(AudioRNNContext *s, DenoiseState *st, float *out, c
     static const float b_hp[2] = {-2, 1};
     int silence;
 
+    for (int i = NB_FEATURES; i < FFALIGN(NB_FEATURES, 4); i++)
+        features[i] = 0.f;
+
     biquad(x, st->mem_hp_x, in, b_hp, a_hp, FRAME_SIZE);
     silence = compute_frame_features(s, st, X, P, Ex, Ep, Exp, features, x);
 
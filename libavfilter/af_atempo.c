@@ -91,6 +91,10 @@ typedef struct ATempoContext {
     // input fragment position may be adjusted backwards:
     uint8_t *buffer;
 
+    // down-mixed mono copy of the ring-buffer, so that each input sample
+    // is down-mixed once rather than once per overlapping fragment load:
+    FFTSample *mono;
+
     // ring-buffer maximum capacity, expressed in sample rate time base:
     int ring;
 
@@ -232,6 +236,7 @@ static void yae_release_buffers(ATempoContext *atempo)
     av_freep(&atempo->frag[1].xdat);
 
     av_freep(&atempo->buffer);
+    av_freep(&atempo->mono);
     av_freep(&atempo->hann);
     av_freep(&atempo->correlation);
 
@@ -314,6 +319,7 @@ static int yae_reset(ATempoContext *atempo,
 
     atempo->ring = atempo->window * 3;
     RE_MALLOC_OR_FAIL(atempo->buffer, atempo->ring * atempo->stride);
+    RE_MALLOC_OR_FAIL(atempo->mono, atempo->ring * sizeof(FFTSample));
 
     // initialize the Hann window function:
     RE_MALLOC_OR_FAIL(atempo->hann, atempo->window * sizeof(float));
@@ -340,77 +346,61 @@ static int yae_update(AVFilterContext *ctx)
 }
 
 /**
- * A helper macro for initializing complex data buffer with scalar data
- * of a given type.
+ * A helper macro for down-mixing packed scalar data of a given type
+ * to mono.
+ *
+ * Multi-channel input is down-mixed by picking the sample with the largest
+ * (clipped) magnitude; the magnitude is compared in abs_type, which may
+ * be an integer type for formats that it represents exactly.  The
+ * selection is kept free of data-dependent branches.
  */
-#define yae_init_xdat(scalar_type, scalar_max)                          \
+#define yae_init_xdat(scalar_type, abs_type, scalar_max)                \
     do {                                                                \
-        const uint8_t *src_end = src +                                  \
-            frag->nsamples * atempo->channels * sizeof(scalar_type);    \
-                                                                        \
-        FFTSample *xdat = frag->xdat;                                   \
-        scalar_type tmp;                                                \
+        const scalar_type *src = (const scalar_type *)data;            \
+        const int channels = atempo->channels;                          \
+        int i, j;                                                       \
                                                                         \
-        if (atempo->channels == 1) {                                    \
-            for (; src < src_end; xdat++) {                             \
-                tmp = *(const scalar_type *)src;                        \
-                src += sizeof(scalar_type);                             \
-                                                                        \
-                *xdat = (FFTSample)tmp;                                 \
-            }                                                           \
+        if (channels == 1) {                                            \
+            for (i = 0; i < nsamples; i++)                              \
+                xdat[i] = (FFTSample)src[i];                            \
         } else {                                                        \
-            FFTSample s, max, ti, si;                                   \
-            int i;                                                      \
-                                                                        \
-            for (; src < src_end; xdat++) {                             \
-                tmp = *(const scalar_type *)src;                        \
-                src += sizeof(scalar_type);                             \
+            for (i = 0; i < nsamples; i++, src += channels) {           \
+                scalar_type max = src[0];                               \
+                abs_type s = FFMIN((abs_type)scalar_max,                \
+                                   FFABS((abs_type)max));               \
                                                                         \
-                max = (FFTSample)tmp;                                   \
-                s = FFMIN((FFTSample)scalar_max,                        \
-                          (FFTSample)fabsf(max));                       \
+                for (j = 1; j < channels; j++) {                        \
+                    const scalar_type ti = src[j];                      \
+                    const abs_type si = FFMIN((abs_type)scalar_max,     \
+                                              FFABS((abs_type)ti));     \
                                                                         \
-                for (i = 1; i < atempo->channels; i++) {                \
-                    tmp = *(const scalar_type *)src;                    \
-                    src += sizeof(scalar_type);                         \
-                                                                        \
-                    ti = (FFTSample)tmp;                                \
-                    si = FFMIN((FFTSample)scalar_max,                   \
-                               (FFTSample)fabsf(ti));                   \
-                                                                        \
-                    if (s < si) {                                       \
-                        s   = si;                                       \
-                        max = ti;                                       \
-                    }                                                   \
+                    max = s < si ? ti : max;                            \
+                    s   = s < si ? si : s;                              \
                 }                                                       \
                                                                         \
-                *xdat = max;                                            \
+                xdat[i] = (FFTSample)max;                               \
             }                                                           \
         }                                                               \
     } while (0)
 
 /**
- * Initialize complex data buffer of a given audio fragment
- * with down-mixed mono data of appropriate scalar type.
+ * Down-mix packed multi-channel samples of appropriate scalar type to mono.
  */
-static void yae_downmix(ATempoContext *atempo, AudioFragment *frag)
+static void yae_downmix(ATempoContext *atempo,
+                        FFTSample *xdat,
+                        const uint8_t *data,
+                        int nsamples)
 {
-    // shortcuts:
-    const uint8_t *src = frag->data;
-
-    // init complex data buffer used for FFT and Correlation:
-    memset(frag->xdat, 0, sizeof(FFTComplex) * atempo->window);
-
     if (atempo->format == AV_SAMPLE_FMT_U8) {
-        yae_init_xdat(uint8_t, 127);
+        yae_init_xdat(uint8_t, FFTSample, 127);
     } else if (atempo->format == AV_SAMPLE_FMT_S16) {
-        yae_init_xdat(int16_t, 32767);
+        yae_init_xdat(int16_t, int, 32767);
     } else if (atempo->format == AV_SAMPLE_FMT_S32) {
-        yae_init_xdat(int, 2147483647);
+        yae_init_xdat(int, FFTSample, 2147483647);
     } else if (atempo->format == AV_SAMPLE_FMT_FLT) {
-        yae_init_xdat(float, 1);
+        yae_init_xdat(float, FFTSample, 1);
     } else if (atempo->format == AV_SAMPLE_FMT_DBL) {
-        yae_init_xdat(double, 1);
+        yae_init_xdat(double, FFTSample, 1);
     }
 }
 
@@ -452,6 +442,7 @@ static int yae_load_data(ATempoContext *atempo,
         if (na) {
             uint8_t *a = atempo->buffer + atempo->tail * atempo->stride;
             memcpy(a, src, na * atempo->stride);
+            yae_downmix(atempo, atempo->mono + atempo->tail, src, na);
 
             src += na * atempo->stride;
             atempo->position[0] += na;
@@ -467,6 +458,7 @@ static int yae_load_data(ATempoContext *atempo,
         if (nb) {
             uint8_t *b = atempo->buffer;
             memcpy(b, src, nb * atempo->stride);
+            yae_downmix(atempo, atempo->mono, src, nb);
 
             src += nb * atempo->stride;
             atempo->position[0] += nb;
@@ -490,56 +482,35 @@ static int yae_load_data(ATempoContext *atempo,
 }
 
 /**
- * Populate current audio fragment data buffer.
- *
- * @return
- *   0 when the fragment is ready,
- *   AVERROR(EAGAIN) if more input data is required.
+ * Copy samples starting at a given input position from a ring-buffer
+ * with elements of a given size, substituting zeros for the samples
+ * that are no longer available.
  */
-static int yae_load_frag(ATempoContext *atempo,
-                         const uint8_t **src_ref,
-                         const uint8_t *src_end)
+static void yae_read_ring(const ATempoContext *atempo,
+                          uint8_t *dst,
+                          const uint8_t *ring,
+                          const int elem_size,
+                          const int64_t position,
+                          const int nsamples)
 {
-    // shortcuts:
-    AudioFragment *frag = yae_curr_frag(atempo);
-    uint8_t *dst;
-    int64_t missing, start, zeros;
-    uint32_t nsamples;
+    int64_t start, zeros;
     const uint8_t *a, *b;
     int i0, i1, n0, n1, na, nb;
 
-    int64_t stop_here = frag->position[0] + atempo->window;
-    if (src_ref && yae_load_data(atempo, src_ref, src_end, stop_here) != 0) {
-        return AVERROR(EAGAIN);
-    }
-
-    // calculate the number of samples we don't have:
-    missing =
-        stop_here > atempo->position[0] ?
-        stop_here - atempo->position[0] : 0;
-
-    nsamples =
-        missing < (int64_t)atempo->window ?
-        (uint32_t)(atempo->window - missing) : 0;
-
-    // setup the output buffer:
-    frag->nsamples = nsamples;
-    dst = frag->data;
-
     start = atempo->position[0] - atempo->size;
     zeros = 0;
 
-    if (frag->position[0] < start) {
+    if (position < start) {
         // what we don't have we substitute with zeros:
-        zeros = FFMIN(start - frag->position[0], (int64_t)nsamples);
+        zeros = FFMIN(start - position, (int64_t)nsamples);
         av_assert0(zeros != nsamples);
 
-        memset(dst, 0, zeros * atempo->stride);
-        dst += zeros * atempo->stride;
+        memset(dst, 0, zeros * elem_size);
+        dst += zeros * elem_size;
     }
 
     if (zeros == nsamples) {
-        return 0;
+        return;
     }
 
     // get the remaining data from the ring buffer:
@@ -552,27 +523,82 @@ static int yae_load_frag(ATempoContext *atempo,
     // sanity check:
     av_assert0(nsamples <= zeros + na + nb);
 
-    a = atempo->buffer + atempo->head * atempo->stride;
-    b = atempo->buffer;
+    a = ring + atempo->head * elem_size;
+    b = ring;
 
-    i0 = frag->position[0] + zeros - start;
+    i0 = position + zeros - start;
     i1 = i0 < na ? 0 : i0 - na;
 
     n0 = i0 < na ? FFMIN(na - i0, (int)(nsamples - zeros)) : 0;
     n1 = nsamples - zeros - n0;
 
     if (n0) {
-        memcpy(dst, a + i0 * atempo->stride, n0 * atempo->stride);
-        dst += n0 * atempo->stride;
+        memcpy(dst, a + i0 * elem_size, n0 * elem_size);
+        dst += n0 * elem_size;
     }
 
     if (n1) {
-        memcpy(dst, b + i1 * atempo->stride, n1 * atempo->stride);
+        memcpy(dst, b + i1 * elem_size, n1 * elem_size);
     }
+}
+
+/**
+ * Populate current audio fragment data buffer.
+ *
+ * @return
+ *   0 when the fragment is ready,
+ *   AVERROR(EAGAIN) if more input data is required.
+ */
+static int yae_load_frag(ATempoContext *atempo,
+                         const uint8_t **src_ref,
+                         const uint8_t *src_end)
+{
+    // shortcuts:
+    AudioFragment *frag = yae_curr_frag(atempo);
+    int64_t missing;
+    uint32_t nsamples;
+
+    int64_t stop_here = frag->position[0] + atempo->window;
+    if (src_ref && yae_load_data(atempo, src_ref, src_end, stop_here) != 0) {
+        return AVERROR(EAGAIN);
+    }
+
+    // calculate the number of samples we don't have:
+    missing =
+        stop_here > atempo->position[0] ?
+        stop_here - atempo->position[0] : 0;
+
+    nsamples =
+        missing < (int64_t)atempo->window ?
+        (uint32_t)(atempo->window - missing) : 0;
+
+    // setup the output buffer:
+    frag->nsamples = nsamples;
+
+    yae_read_ring(atempo, frag->data, atempo->buffer, atempo->stride,
+                  frag->position[0], nsamples);
 
     return 0;
 }
 
+/**
+ * Initialize complex data buffer of a given audio fragment
+ * with down-mixed mono data.
+ *
+ * Must be called right after the fragment was (re)loaded,
+ * while the ring-buffer still holds the same samples.
+ */
+static void yae_load_xdat(ATempoContext *atempo, AudioFragment *frag)
+{
+    yae_read_ring(atempo, (uint8_t *)frag->xdat, (const uint8_t *)atempo->mono,
+                  sizeof(FFTSample), frag->position[0], frag->nsamples);
+
+    // zero-pad the complex data buffer used for FFT and Correlation:
+    memset(frag->xdat + frag->nsamples, 0,
+           sizeof(FFTComplex) * atempo->window -
+           sizeof(FFTSample) * frag->nsamples);
+}
+
 /**
  * Prepare for loading next audio fragment.
  */
@@ -729,28 +755,25 @@ static int yae_adjust_position(ATempoContext *atempo)
         const scalar_type *aaa = (const scalar_type *)a;                \
         const scalar_type *bbb = (const scalar_type *)b;                \
                                                                         \
-        scalar_type *out     = (scalar_type *)dst;                      \
-        scalar_type *out_end = (scalar_type *)dst_end;                  \
+        scalar_type *out = (scalar_type *)dst;                          \
         int64_t i;                                                      \
+        int j;                                                          \
                                                                         \
-        for (i = 0; i < overlap && out < out_end;                       \
-             i++, atempo->position[1]++, wa++, wb++) {                  \
-            float w0 = *wa;                                             \
-            float w1 = *wb;                                             \
-            int j;                                                      \
+        for (i = 0; i < nblend; i++) {                                  \
+            const float w0 = wa[i];                                     \
+            const float w1 = wb[i];                                     \
                                                                         \
-            for (j = 0; j < atempo->channels;                           \
-                 j++, aaa++, bbb++, out++) {                            \
-                float t0 = (float)*aaa;                                 \
-                float t1 = (float)*bbb;                                 \
+            for (j = 0; j < channels; j++) {                            \
+                const float t0 = (float)aaa[j];                         \
+                const float t1 = (float)bbb[j];                         \
                                                                         \
-                *out =                                                  \
-                    frag->position[0] + i < 0 ?                         \
-                    *aaa :                                              \
-                    (scalar_type)(t0 * w0 + t1 * w1);                   \
+                out[j] = (scalar_type)(t0 * w0 + t1 * w1);              \
             }                                                           \
+                                                                        \
+            aaa += channels;                                            \
+            bbb += channels;                                            \
+            out += channels;                                            \
         }                                                               \
-        dst = (uint8_t *)out;                                           \
     } while (0)
 
 /**
@@ -788,10 +811,29 @@ static int yae_overlap_add(ATempoContext *atempo,
 
     uint8_t *dst = *dst_ref;
 
+    const int channels = atempo->channels;
+    int64_t ncopy, nblend;
+
     av_assert0(start_here <= stop_here &&
                frag->position[1] <= start_here &&
                overlap <= frag->nsamples);
 
+    // clamp to the available destination buffer space:
+    nblend = FFMIN(overlap, (dst_end - dst) / atempo->stride);
+
+    // samples preceding the start of the input stream
+    // are passed through from the previous fragment:
+    ncopy = av_clip64(-frag->position[0], 0, nblend);
+    if (ncopy) {
+        memcpy(dst, a, ncopy * atempo->stride);
+        a   += ncopy * atempo->stride;
+        b   += ncopy * atempo->stride;
+        dst += ncopy * atempo->stride;
+        wa  += ncopy;
+        wb  += ncopy;
+        nblend -= ncopy;
+    }
+
     if (atempo->format == AV_SAMPLE_FMT_U8) {
         yae_blend(uint8_t);
     } else if (atempo->format == AV_SAMPLE_FMT_S16) {
@@ -804,6 +846,9 @@ static int yae_overlap_add(ATempoContext *atempo,
         yae_blend(double);
     }
 
+    dst += nblend * atempo->stride;
+    atempo->position[1] += ncopy + nblend;
+
     // pass-back the updated destination buffer pointer:
     *dst_ref = dst;
 
@@ -829,8 +874,8 @@ yae_apply(ATempoContext *atempo,
                 break;
             }
 
-            // down-mix to mono:
-            yae_downmix(atempo, yae_curr_frag(atempo));
+            // load down-mixed mono data:
+            yae_load_xdat(atempo, yae_curr_frag(atempo));
 
             // apply rDFT:
             av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
@@ -861,8 +906,8 @@ yae_apply(ATempoContext *atempo,
                 break;
             }
 
-            // down-mix to mono:
-            yae_downmix(atempo, yae_curr_frag(atempo));
+            // load down-mixed mono data:
+            yae_load_xdat(atempo, yae_curr_frag(atempo));
 
             // apply rDFT:
             av_rdft_calc(atempo->real_to_complex, yae_curr_frag(atempo)->xdat);
@@ -925,8 +970,8 @@ static int yae_flush(ATempoContext *atempo,
         yae_load_frag(atempo, NULL, NULL);
 
         if (atempo->nfrag) {
-            // down-mix to mono:
-            yae_downmix(atempo, frag);
+            // load down-mixed mono data:
+            yae_load_xdat(atempo, frag);
 
             // apply rDFT:
             av_rdft_calc(atempo->real_to_complex, frag->xdat);
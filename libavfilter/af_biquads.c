@@ -124,6 +124,8 @@ typedef struct BiquadsContext {
                    double *i1, double *i2, double *o1, double *o2,
                    double b0, double b1, double b2, double a1, double a2, int *clippings,
                    int disabled);
+    void (*filter_lanes)(struct BiquadsContext *s, uint8_t **ibuf, uint8_t **obuf,
+                         int len, ChanCache **cache, int disabled);
 } BiquadsContext;
 
 static av_cold int init(AVFilterContext *ctx)
@@ -257,6 +259,103 @@ BIQUAD_FILTER(s32, int32_t, INT32_MIN, INT32_MAX, 1)
 BIQUAD_FILTER(flt, float,   -1., 1., 0)
 BIQUAD_FILTER(dbl, double,  -1., 1., 0)
 
+/*
+ * All channels share the same coefficients, so BIQUAD_LANES channels are
+ * run through the recursion in lockstep: the feedback chains of the lanes
+ * are independent and overlap in the pipeline, while each lane performs
+ * exactly the same operations as biquad_*() above. More lanes no longer
+ * fit the state into the x86-64 SSE register file.
+ */
+#define BIQUAD_LANES 2
+
+#define BIQUAD_STORE(dst, out, in, clippings, min, max, need_clipping)        \
+    if (disabled) {                                                           \
+        dst = in;                                                             \
+    } else if (need_clipping && out < min) {                                  \
+        (clippings)++;                                                        \
+        dst = min;                                                            \
+    } else if (need_clipping && out > max) {                                  \
+        (clippings)++;                                                        \
+        dst = max;                                                            \
+    } else {                                                                  \
+        dst = out;                                                            \
+    }
+
+#define BIQUAD_FILTER_LANES(name, type, min, max, need_clipping)              \
+static void biquad_lanes_## name (BiquadsContext *s,                          \
+                                  uint8_t **input, uint8_t **output, int len, \
+                                  ChanCache **cache, int disabled)            \
+{                                                                             \
+    const type *ibuf[BIQUAD_LANES];                                           \
+    type *obuf[BIQUAD_LANES];                                                 \
+    double i1[BIQUAD_LANES], i2[BIQUAD_LANES];                                \
+    double o1[BIQUAD_LANES], o2[BIQUAD_LANES];                                \
+    const double b0 = s->b0;                                                  \
+    const double b1 = s->b1;                                                  \
+    const double b2 = s->b2;                                                  \
+    const double a1 = -s->a1;                                                 \
+    const double a2 = -s->a2;                                                 \
+    double wet = s->mix;                                                      \
+    double dry = 1. - wet;                                                    \
+    double out;                                                               \
+    int i, c;                                                                 \
+                                                                              \
+    for (c = 0; c < BIQUAD_LANES; c++) {                                      \
+        ibuf[c] = (const type *)input[c];                                     \
+        obuf[c] = (type *)output[c];                                          \
+        i1[c] = cache[c]->i1;                                                 \
+        i2[c] = cache[c]->i2;                                                 \
+        o1[c] = cache[c]->o1;                                                 \
+        o2[c] = cache[c]->o2;                                                 \
+    }                                                                         \
+                                                                              \
+    for (i = 0; i+1 < len; i++) {                                             \
+        for (c = 0; c < BIQUAD_LANES; c++) {                                  \
+            o2[c] = i2[c] * b2 + i1[c] * b1 + ibuf[c][i] * b0 + o2[c] * a2 + o1[c] * a1; \
+            i2[c] = ibuf[c][i];                                               \
+        }                                                                     \
+        for (c = 0; c < BIQUAD_LANES; c++) {                                  \
+            out = o2[c] * wet + i2[c] * dry;                                  \
+            BIQUAD_STORE(obuf[c][i], out, i2[c], cache[c]->clippings,         \
+                         min, max, need_clipping)                             \
+        }                                                                     \
+        i++;                                                                  \
+        for (c = 0; c < BIQUAD_LANES; c++) {                                  \
+            o1[c] = i1[c] * b2 + i2[c] * b1 + ibuf[c][i] * b0 + o1[c] * a2 + o2[c] * a1; \
+            i1[c] = ibuf[c][i];                                               \
+        }                                                                     \
+        for (c = 0; c < BIQUAD_LANES; c++) {                                  \
+            out = o1[c] * wet + i1[c] * dry;                                  \
+            BIQUAD_STORE(obuf[c][i], out, i1[c], cache[c]->clippings,         \
+                         min, max, need_clipping)                             \
+        }                                                                     \
+    }                                                                         \
+    if (i < len) {                                                            \
+        for (c = 0; c < BIQUAD_LANES; c++) {                                  \
+            double o0 = ibuf[c][i] * b0 + i1[c] * b1 + i2[c] * b2 + o1[c] * a1 + o2[c] * a2; \
+            i2[c] = i1[c];                                                    \
+            i1[c] = ibuf[c][i];                                               \
+            o2[c] = o1[c];                                                    \
+            o1[c] = o0;                                                       \
+            out = o0 * wet + i1[c] * dry;                                     \
+            BIQUAD_STORE(obuf[c][i], out, i1[c], cache[c]->clippings,         \
+                         min, max, need_clipping)                             \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    for (c = 0; c < BIQUAD_LANES; c++) {                                      \
+        cache[c]->i1 = i1[c];                                                 \
+        cache[c]->i2 = i2[c];                                                 \
+        cache[c]->o1 = o1[c];                                                 \
+        cache[c]->o2 = o2[c];                                                 \
+    }                                                                         \
+}
+
+BIQUAD_FILTER_LANES(s16, int16_t, INT16_MIN, INT16_MAX, 1)
+BIQUAD_FILTER_LANES(s32, int32_t, INT32_MIN, INT32_MAX, 1)
+BIQUAD_FILTER_LANES(flt, float,   -1., 1., 0)
+BIQUAD_FILTER_LANES(dbl, double,  -1., 1., 0)
+
 static int config_filter(AVFilterLink *outlink, int reset)
 {
     AVFilterContext *ctx    = outlink->src;
@@ -424,10 +523,22 @@ static int config_filter(AVFilterLink *outlink, int reset)
         memset(s->cache, 0, sizeof(ChanCache) * inlink->channels);
 
     switch (inlink->format) {
-    case AV_SAMPLE_FMT_S16P: s->filter = biquad_s16; break;
-    case AV_SAMPLE_FMT_S32P: s->filter = biquad_s32; break;
-    case AV_SAMPLE_FMT_FLTP: s->filter = biquad_flt; break;
-    case AV_SAMPLE_FMT_DBLP: s->filter = biquad_dbl; break;
+    case AV_SAMPLE_FMT_S16P:
+        s->filter       = biquad_s16;
+        s->filter_lanes = biquad_lanes_s16;
+        break;
+    case AV_SAMPLE_FMT_S32P:
+        s->filter       = biquad_s32;
+        s->filter_lanes = biquad_lanes_s32;
+        break;
+    case AV_SAMPLE_FMT_FLTP:
+        s->filter       = biquad_flt;
+        s->filter_lanes = biquad_lanes_flt;
+        break;
+    case AV_SAMPLE_FMT_DBLP:
+        s->filter       = biquad_dbl;
+        s->filter_lanes = biquad_lanes_dbl;
+        break;
     default: av_assert0(0);
     }
 
@@ -454,7 +565,9 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
     BiquadsContext *s = ctx->priv;
     const int start = (buf->channels * jobnr) / nb_jobs;
     const int end = (buf->channels * (jobnr+1)) / nb_jobs;
-    int ch;
+    uint8_t *ibuf[BIQUAD_LANES], *obuf[BIQUAD_LANES];
+    ChanCache *cache[BIQUAD_LANES];
+    int ch, c, nb_lanes = 0;
 
     for (ch = start; ch < end; ch++) {
         if (!((av_channel_layout_extract_channel(inlink->channel_layout, ch) & s->channels))) {
@@ -464,9 +577,19 @@ static int filter_channel(AVFilterContext *ctx, void *arg, int jobnr, int nb_job
             continue;
         }
 
-        s->filter(s, buf->extended_data[ch], out_buf->extended_data[ch], buf->nb_samples,
-                  &s->cache[ch].i1, &s->cache[ch].i2, &s->cache[ch].o1, &s->cache[ch].o2,
-                  s->b0, s->b1, s->b2, s->a1, s->a2, &s->cache[ch].clippings, ctx->is_disabled);
+        ibuf[nb_lanes]  = buf->extended_data[ch];
+        obuf[nb_lanes]  = out_buf->extended_data[ch];
+        cache[nb_lanes] = &s->cache[ch];
+        if (++nb_lanes == BIQUAD_LANES) {
+            s->filter_lanes(s, ibuf, obuf, buf->nb_samples, cache, ctx->is_disabled);
+            nb_lanes = 0;
+        }
+    }
+
+    for (c = 0; c < nb_lanes; c++) {
+        s->filter(s, ibuf[c], obuf[c], buf->nb_samples,
+                  &cache[c]->i1, &cache[c]->i2, &cache[c]->o1, &cache[c]->o2,
+                  s->b0, s->b1, s->b2, s->a1, s->a2, &cache[c]->clippings, ctx->is_disabled);
     }
 
     return 0;
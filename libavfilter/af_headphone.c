@@ -27,6 +27,7 @@
 #include "libavutil/opt.h"
 #include "libavcodec/avfft.h"
 
+#include "af_afirdsp.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "internal.h"
@@ -66,18 +67,21 @@ typedef struct HeadphoneContext {
 
     int buffer_length;
     int n_fft;
+    int block_size;
     int size;
     int hrir_fmt;
 
     int *delay[2];
     float *data_ir[2];
     float *temp_src[2];
-    FFTComplex *temp_fft[2];
-    FFTComplex *temp_afft[2];
+    float *temp_fft;
+    float *temp_afft[2];
 
-    FFTContext *fft[2], *ifft[2];
-    FFTComplex *data_hrtf[2];
+    RDFTContext **rdft, *irdft[2];
+    int nb_rdft;
+    float *data_hrtf[2];
 
+    AudioFIRDSPContext afirdsp;
     AVFloatDSPContext *fdsp;
     struct headphone_inputs {
         AVFrame     *frame;
@@ -158,8 +162,6 @@ typedef struct ThreadData {
     int *n_clippings;
     float **ringbuffer;
     float **temp_src;
-    FFTComplex **temp_fft;
-    FFTComplex **temp_afft;
 } ThreadData;
 
 static int headphone_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -213,10 +215,10 @@ static int headphone_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
             if (read + ir_len < buffer_length) {
                 memcpy(temp_src, bptr + read, ir_len * sizeof(*temp_src));
             } else {
-                int len = FFMIN(air_len - (read % ir_len), buffer_length - read);
+                int len = buffer_length - read;
 
                 memcpy(temp_src, bptr + read, len * sizeof(*temp_src));
-                memcpy(temp_src + len, bptr, (air_len - len) * sizeof(*temp_src));
+                memcpy(temp_src + len, bptr, (ir_len - len) * sizeof(*temp_src));
             }
 
             dst[0] += s->fdsp->scalarproduct_float(temp_ir, temp_src, FFALIGN(ir_len, 32));
@@ -236,6 +238,36 @@ static int headphone_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
+static int headphone_fft_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    HeadphoneContext *s = ctx->priv;
+    AVFrame *in = arg;
+    const int in_channels = in->channels;
+    const int start = (in_channels * jobnr) / nb_jobs;
+    const int end = (in_channels * (jobnr+1)) / nb_jobs;
+    const float *src = (const float *)in->data[0];
+    const int n_fft = s->n_fft;
+    int i, j;
+
+    for (i = start; i < end; i++) {
+        float *block = s->temp_fft + i * s->block_size;
+
+        if (i == s->lfe_channel)
+            continue;
+
+        for (j = 0; j < in->nb_samples; j++) {
+            block[j] = src[j * in_channels + i];
+        }
+        memset(block + in->nb_samples, 0, sizeof(*block) * (n_fft - in->nb_samples));
+
+        av_rdft_calc(s->rdft[i], block);
+        block[n_fft] = block[1];
+        block[1] = 0;
+    }
+
+    return 0;
+}
+
 static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     HeadphoneContext *s = ctx->priv;
@@ -243,7 +275,7 @@ static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     AVFrame *in = td->in, *out = td->out;
     int offset = jobnr;
     int *write = &td->write[jobnr];
-    FFTComplex *hrtf = s->data_hrtf[jobnr];
+    const float *hrtf = s->data_hrtf[jobnr];
     int *n_clippings = &td->n_clippings[jobnr];
     float *ringbuffer = td->ringbuffer[jobnr];
     const int ir_len = s->ir_len;
@@ -252,13 +284,10 @@ static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     const int in_channels = in->channels;
     const int buffer_length = s->buffer_length;
     const uint32_t modulo = (uint32_t)buffer_length - 1;
-    FFTComplex *fft_in = s->temp_fft[jobnr];
-    FFTComplex *fft_acc = s->temp_afft[jobnr];
-    FFTContext *ifft = s->ifft[jobnr];
-    FFTContext *fft = s->fft[jobnr];
+    float *fft_acc = s->temp_afft[jobnr];
+    RDFTContext *irdft = s->irdft[jobnr];
     const int n_fft = s->n_fft;
-    const float fft_scale = 1.0f / s->n_fft;
-    FFTComplex *hrtf_offset;
+    const float fft_scale = 2.0f / s->n_fft;
     int wr = *write;
     int n_read;
     int i, j;
@@ -276,7 +305,7 @@ static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
         dst[2 * j] = 0;
     }
 
-    memset(fft_acc, 0, sizeof(FFTComplex) * n_fft);
+    memset(fft_acc, 0, sizeof(*fft_acc) * s->block_size);
 
     for (i = 0; i < in_channels; i++) {
         if (i == s->lfe_channel) {
@@ -286,38 +315,21 @@ static int headphone_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
             continue;
         }
 
-        offset = i * n_fft;
-        hrtf_offset = hrtf + offset;
-
-        memset(fft_in, 0, sizeof(FFTComplex) * n_fft);
-
-        for (j = 0; j < in->nb_samples; j++) {
-            fft_in[j].re = src[j * in_channels + i];
-        }
-
-        av_fft_permute(fft, fft_in);
-        av_fft_calc(fft, fft_in);
-        for (j = 0; j < n_fft; j++) {
-            const FFTComplex *hcomplex = hrtf_offset + j;
-            const float re = fft_in[j].re;
-            const float im = fft_in[j].im;
-
-            fft_acc[j].re += re * hcomplex->re - im * hcomplex->im;
-            fft_acc[j].im += re * hcomplex->im + im * hcomplex->re;
-        }
+        s->afirdsp.fcmul_add(fft_acc, s->temp_fft + i * s->block_size,
+                             hrtf + i * s->block_size, n_fft / 2);
     }
 
-    av_fft_permute(ifft, fft_acc);
-    av_fft_calc(ifft, fft_acc);
+    fft_acc[1] = fft_acc[n_fft];
+    av_rdft_calc(irdft, fft_acc);
 
     for (j = 0; j < in->nb_samples; j++) {
-        dst[2 * j] += fft_acc[j].re * fft_scale;
+        dst[2 * j] += fft_acc[j] * fft_scale;
     }
 
     for (j = 0; j < ir_len - 1; j++) {
         int write_pos = (wr + j) & modulo;
 
-        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j].re * fft_scale;
+        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j] * fft_scale;
     }
 
     for (i = 0; i < out->nb_samples; i++) {
@@ -368,12 +380,13 @@ static int headphone_frame(HeadphoneContext *s, AVFrame *in, AVFilterLink *outli
     td.in = in; td.out = out; td.write = s->write;
     td.delay = s->delay; td.ir = s->data_ir; td.n_clippings = n_clippings;
     td.ringbuffer = s->ringbuffer; td.temp_src = s->temp_src;
-    td.temp_fft = s->temp_fft;
-    td.temp_afft = s->temp_afft;
 
     if (s->type == TIME_DOMAIN) {
         ctx->internal->execute(ctx, headphone_convolute, &td, NULL, 2);
     } else {
+        // transform each input channel once, both ears share the spectra:
+        ctx->internal->execute(ctx, headphone_fft_channels, in, NULL,
+                               FFMIN(in->channels, ff_filter_get_nb_threads(ctx)));
         ctx->internal->execute(ctx, headphone_fast_convolute, &td, NULL, 2);
     }
     emms_c();
@@ -387,6 +400,14 @@ static int headphone_frame(HeadphoneContext *s, AVFrame *in, AVFilterLink *outli
     return ff_filter_frame(outlink, out);
 }
 
+static void hrtf_rdft(HeadphoneContext *s, float *block, float *hrtf)
+{
+    av_rdft_calc(s->rdft[0], block);
+    block[s->n_fft] = block[1];
+    block[1] = 0;
+    memcpy(hrtf, block, s->block_size * sizeof(*block));
+}
+
 static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
 {
     struct HeadphoneContext *s = ctx->priv;
@@ -394,39 +415,48 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
     int nb_irs = s->nb_irs;
     int nb_input_channels = ctx->inputs[0]->channels;
     float gain_lin = expf((s->gain - 3 * nb_input_channels) / 20 * M_LN10);
-    FFTComplex *data_hrtf_l = NULL;
-    FFTComplex *data_hrtf_r = NULL;
-    FFTComplex *fft_in_l = NULL;
-    FFTComplex *fft_in_r = NULL;
+    float *data_hrtf_l = NULL;
+    float *data_hrtf_r = NULL;
+    float *fft_in_l = NULL;
+    float *fft_in_r = NULL;
     float *data_ir_l = NULL;
     float *data_ir_r = NULL;
     int offset = 0, ret = 0;
-    int n_fft;
+    int n_fft, block_size;
     int i, j, k;
 
     s->air_len = 1 << (32 - ff_clz(ir_len));
     s->buffer_length = 1 << (32 - ff_clz(s->air_len));
     s->n_fft = n_fft = 1 << (32 - ff_clz(ir_len + s->size));
+    // rDFT output plus the Nyquist bin, padded for the fcmul_add alignment:
+    s->block_size = block_size = FFALIGN(n_fft + 1, 16);
 
     if (s->type == FREQUENCY_DOMAIN) {
-        fft_in_l = av_calloc(n_fft, sizeof(*fft_in_l));
-        fft_in_r = av_calloc(n_fft, sizeof(*fft_in_r));
+        fft_in_l = av_calloc(block_size, sizeof(*fft_in_l));
+        fft_in_r = av_calloc(block_size, sizeof(*fft_in_r));
         if (!fft_in_l || !fft_in_r) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
 
-        av_fft_end(s->fft[0]);
-        av_fft_end(s->fft[1]);
-        s->fft[0] = av_fft_init(av_log2(s->n_fft), 0);
-        s->fft[1] = av_fft_init(av_log2(s->n_fft), 0);
-        av_fft_end(s->ifft[0]);
-        av_fft_end(s->ifft[1]);
-        s->ifft[0] = av_fft_init(av_log2(s->n_fft), 1);
-        s->ifft[1] = av_fft_init(av_log2(s->n_fft), 1);
-
-        if (!s->fft[0] || !s->fft[1] || !s->ifft[0] || !s->ifft[1]) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT contexts of size %d.\n", s->n_fft);
+        s->rdft = av_calloc(nb_input_channels, sizeof(*s->rdft));
+        if (!s->rdft) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+
+        s->nb_rdft = nb_input_channels;
+
+        for (i = 0; i < nb_input_channels; i++) {
+            s->rdft[i] = av_rdft_init(av_log2(s->n_fft), DFT_R2C);
+            if (!s->rdft[i])
+                break;
+        }
+        s->irdft[0] = av_rdft_init(av_log2(s->n_fft), IDFT_C2R);
+        s->irdft[1] = av_rdft_init(av_log2(s->n_fft), IDFT_C2R);
+
+        if (i < nb_input_channels || !s->irdft[0] || !s->irdft[1]) {
+            av_log(ctx, AV_LOG_ERROR, "Unable to create RDFT contexts of size %d.\n", s->n_fft);
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -443,12 +473,10 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
     } else {
         s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float));
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float));
-        s->temp_fft[0] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_fft[1] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[0] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[1] = av_calloc(s->n_fft, sizeof(FFTComplex));
-        if (!s->temp_fft[0] || !s->temp_fft[1] ||
-            !s->temp_afft[0] || !s->temp_afft[1]) {
+        s->temp_fft = av_calloc(block_size, sizeof(float) * nb_input_channels);
+        s->temp_afft[0] = av_calloc(block_size, sizeof(float));
+        s->temp_afft[1] = av_calloc(block_size, sizeof(float));
+        if (!s->temp_fft || !s->temp_afft[0] || !s->temp_afft[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -471,8 +499,8 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
             goto fail;
         }
     } else {
-        data_hrtf_l = av_calloc(n_fft, sizeof(*data_hrtf_l) * nb_irs);
-        data_hrtf_r = av_calloc(n_fft, sizeof(*data_hrtf_r) * nb_irs);
+        data_hrtf_l = av_calloc(block_size, sizeof(*data_hrtf_l) * nb_irs);
+        data_hrtf_r = av_calloc(block_size, sizeof(*data_hrtf_r) * nb_irs);
         if (!data_hrtf_r || !data_hrtf_l) {
             ret = AVERROR(ENOMEM);
             goto fail;
@@ -513,21 +541,17 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
                     data_ir_r[offset + j] = ptr[len * 2 - j * 2 - 1] * gain_lin;
                 }
             } else {
-                memset(fft_in_l, 0, n_fft * sizeof(*fft_in_l));
-                memset(fft_in_r, 0, n_fft * sizeof(*fft_in_r));
+                memset(fft_in_l, 0, block_size * sizeof(*fft_in_l));
+                memset(fft_in_r, 0, block_size * sizeof(*fft_in_r));
 
-                offset = idx * n_fft;
+                offset = idx * block_size;
                 for (j = 0; j < len; j++) {
-                    fft_in_l[delay_l + j].re = ptr[j * 2    ] * gain_lin;
-                    fft_in_r[delay_r + j].re = ptr[j * 2 + 1] * gain_lin;
+                    fft_in_l[delay_l + j] = ptr[j * 2    ] * gain_lin;
+                    fft_in_r[delay_r + j] = ptr[j * 2 + 1] * gain_lin;
                 }
 
-                av_fft_permute(s->fft[0], fft_in_l);
-                av_fft_calc(s->fft[0], fft_in_l);
-                memcpy(data_hrtf_l + offset, fft_in_l, n_fft * sizeof(*fft_in_l));
-                av_fft_permute(s->fft[0], fft_in_r);
-                av_fft_calc(s->fft[0], fft_in_r);
-                memcpy(data_hrtf_r + offset, fft_in_r, n_fft * sizeof(*fft_in_r));
+                hrtf_rdft(s, fft_in_l, data_hrtf_l + offset);
+                hrtf_rdft(s, fft_in_r, data_hrtf_r + offset);
             }
         } else {
             int I, N = ctx->inputs[1]->channels;
@@ -556,21 +580,17 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
                         data_ir_r[offset + j] = ptr[len * N - j * N - N + I + 1] * gain_lin;
                     }
                 } else {
-                    memset(fft_in_l, 0, n_fft * sizeof(*fft_in_l));
-                    memset(fft_in_r, 0, n_fft * sizeof(*fft_in_r));
+                    memset(fft_in_l, 0, block_size * sizeof(*fft_in_l));
+                    memset(fft_in_r, 0, block_size * sizeof(*fft_in_r));
 
-                    offset = idx * n_fft;
+                    offset = idx * block_size;
                     for (j = 0; j < len; j++) {
-                        fft_in_l[delay_l + j].re = ptr[j * N + I    ] * gain_lin;
-                        fft_in_r[delay_r + j].re = ptr[j * N + I + 1] * gain_lin;
+                        fft_in_l[delay_l + j] = ptr[j * N + I    ] * gain_lin;
+                        fft_in_r[delay_r + j] = ptr[j * N + I + 1] * gain_lin;
                     }
 
-                    av_fft_permute(s->fft[0], fft_in_l);
-                    av_fft_calc(s->fft[0], fft_in_l);
-                    memcpy(data_hrtf_l + offset, fft_in_l, n_fft * sizeof(*fft_in_l));
-                    av_fft_permute(s->fft[0], fft_in_r);
-                    av_fft_calc(s->fft[0], fft_in_r);
-                    memcpy(data_hrtf_r + offset, fft_in_r, n_fft * sizeof(*fft_in_r));
+                    hrtf_rdft(s, fft_in_l, data_hrtf_l + offset);
+                    hrtf_rdft(s, fft_in_r, data_hrtf_r + offset);
                 }
             }
         }
@@ -582,17 +602,17 @@ static int convert_coeffs(AVFilterContext *ctx, AVFilterLink *inlink)
         memcpy(s->data_ir[0], data_ir_l, sizeof(float) * nb_irs * s->air_len);
         memcpy(s->data_ir[1], data_ir_r, sizeof(float) * nb_irs * s->air_len);
     } else {
-        s->data_hrtf[0] = av_calloc(n_fft * s->nb_irs, sizeof(FFTComplex));
-        s->data_hrtf[1] = av_calloc(n_fft * s->nb_irs, sizeof(FFTComplex));
+        s->data_hrtf[0] = av_calloc(block_size * s->nb_irs, sizeof(float));
+        s->data_hrtf[1] = av_calloc(block_size * s->nb_irs, sizeof(float));
         if (!s->data_hrtf[0] || !s->data_hrtf[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
 
         memcpy(s->data_hrtf[0], data_hrtf_l,
-            sizeof(FFTComplex) * nb_irs * n_fft);
+            sizeof(float) * nb_irs * block_size);
         memcpy(s->data_hrtf[1], data_hrtf_r,
-            sizeof(FFTComplex) * nb_irs * n_fft);
+            sizeof(float) * nb_irs * block_size);
     }
 
     s->have_hrirs = 1;
@@ -785,6 +805,7 @@ static av_cold int init(AVFilterContext *ctx)
     s->fdsp = avpriv_float_dsp_alloc(0);
     if (!s->fdsp)
         return AVERROR(ENOMEM);
+    ff_afir_init(&s->afirdsp);
 
     return 0;
 }
@@ -814,10 +835,11 @@ static av_cold void uninit(AVFilterContext *ctx)
     HeadphoneContext *s = ctx->priv;
     int i;
 
-    av_fft_end(s->ifft[0]);
-    av_fft_end(s->ifft[1]);
-    av_fft_end(s->fft[0]);
-    av_fft_end(s->fft[1]);
+    for (i = 0; i < s->nb_rdft; i++)
+        av_rdft_end(s->rdft[i]);
+    av_freep(&s->rdft);
+    av_rdft_end(s->irdft[0]);
+    av_rdft_end(s->irdft[1]);
     av_freep(&s->delay[0]);
     av_freep(&s->delay[1]);
     av_freep(&s->data_ir[0]);
@@ -826,8 +848,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->ringbuffer[1]);
     av_freep(&s->temp_src[0]);
     av_freep(&s->temp_src[1]);
-    av_freep(&s->temp_fft[0]);
-    av_freep(&s->temp_fft[1]);
+    av_freep(&s->temp_fft);
     av_freep(&s->temp_afft[0]);
     av_freep(&s->temp_afft[1]);
     av_freep(&s->data_hrtf[0]);
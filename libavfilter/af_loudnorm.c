@@ -130,6 +130,14 @@ static inline int frame_size(int sample_rate, int frame_len_msec)
     return frame_size + (frame_size % 2);
 }
 
+static void get_peak(FFEBUR128State *st, int channel, double *peak)
+{
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK)
+        ff_ebur128_true_peak(st, channel, peak);
+    else
+        ff_ebur128_sample_peak(st, channel, peak);
+}
+
 static void init_gaussian_filter(LoudNormContext *s)
 {
     double total_weight = 0.0;
@@ -448,7 +456,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         ff_ebur128_loudness_global(s->r128_in, &global);
         for (c = 0; c < inlink->channels; c++) {
             double tmp;
-            ff_ebur128_sample_peak(s->r128_in, c, &tmp);
+            get_peak(s->r128_in, c, &tmp);
             if (c == 0 || tmp > true_peak)
                 true_peak = tmp;
         }
@@ -730,12 +738,16 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    /* oversampling is only needed below 96 kHz; outside of linear mode
+     * the input is always 192 kHz and the sample peak is the true peak */
+    int peak_mode = inlink->sample_rate < 96000 ? FF_EBUR128_MODE_TRUE_PEAK
+                                                : FF_EBUR128_MODE_SAMPLE_PEAK;
 
-    s->r128_in = ff_ebur128_init(inlink->channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    s->r128_in = ff_ebur128_init(inlink->channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | peak_mode);
     if (!s->r128_in)
         return AVERROR(ENOMEM);
 
-    s->r128_out = ff_ebur128_init(inlink->channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    s->r128_out = ff_ebur128_init(inlink->channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | peak_mode);
     if (!s->r128_out)
         return AVERROR(ENOMEM);
 
@@ -816,7 +828,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     ff_ebur128_relative_threshold(s->r128_in, &thresh_in);
     for (c = 0; c < s->channels; c++) {
         double tmp;
-        ff_ebur128_sample_peak(s->r128_in, c, &tmp);
+        get_peak(s->r128_in, c, &tmp);
         if ((c == 0) || (tmp > tp_in))
             tp_in = tmp;
     }
@@ -826,7 +838,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
     for (c = 0; c < s->channels; c++) {
         double tmp;
-        ff_ebur128_sample_peak(s->r128_out, c, &tmp);
+        get_peak(s->r128_out, c, &tmp);
         if ((c == 0) || (tmp > tp_out))
             tp_out = tmp;
     }
@@ -34,6 +34,7 @@
 #include "libavutil/float_dsp.h"
 #include "libavutil/intmath.h"
 #include "libavutil/opt.h"
+#include "af_afirdsp.h"
 #include "avfilter.h"
 #include "filters.h"
 #include "internal.h"
@@ -82,6 +83,7 @@ typedef struct SOFAlizerContext {
     int buffer_length;          /* is: longest IR plus max. delay in all SOFA files */
                                 /* then choose next power of 2 */
     int n_fft;                  /* number of samples in one FFT block */
+    int block_size;             /* number of floats holding one rDFT spectrum */
     int nb_samples;
 
                                 /* netCDF variables */
@@ -90,8 +92,8 @@ typedef struct SOFAlizerContext {
     float *data_ir[2];          /* IRs for all channels to be convolved */
                                 /* (this excludes the LFE) */
     float *temp_src[2];
-    FFTComplex *temp_fft[2];    /* Array to hold FFT values */
-    FFTComplex *temp_afft[2];   /* Array to accumulate FFT values prior to IFFT */
+    float *temp_fft;            /* Array to hold FFT values of all input channels */
+    float *temp_afft[2];        /* Array to accumulate FFT values prior to IFFT */
 
                          /* control variables */
     float gain;          /* filter gain (in dB) */
@@ -108,9 +110,11 @@ typedef struct SOFAlizerContext {
 
     VirtualSpeaker vspkrpos[64];
 
-    FFTContext *fft[2], *ifft[2];
-    FFTComplex *data_hrtf[2];
+    RDFTContext **rdft, *irdft[2];
+    int nb_rdft;
+    float *data_hrtf[2];
 
+    AudioFIRDSPContext afirdsp;
     AVFloatDSPContext *fdsp;
 } SOFAlizerContext;
 
@@ -324,8 +328,6 @@ typedef struct ThreadData {
     int *n_clippings;
     float **ringbuffer;
     float **temp_src;
-    FFTComplex **temp_fft;
-    FFTComplex **temp_afft;
 } ThreadData;
 
 static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -402,10 +404,10 @@ static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
             if (read + ir_samples < buffer_length) {
                 memmove(temp_src, bptr + read, ir_samples * sizeof(*temp_src));
             } else {
-                int len = FFMIN(n_samples - (read % ir_samples), buffer_length - read);
+                int len = buffer_length - read;
 
                 memmove(temp_src, bptr + read, len * sizeof(*temp_src));
-                memmove(temp_src + len, bptr, (n_samples - len) * sizeof(*temp_src));
+                memmove(temp_src + len, bptr, (ir_samples - len) * sizeof(*temp_src));
             }
 
             /* multiply signal and IR, and add up the results */
@@ -428,6 +430,49 @@ static int sofalizer_convolute(AVFilterContext *ctx, void *arg, int jobnr, int n
     return 0;
 }
 
+static int sofalizer_fft_channels(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SOFAlizerContext *s = ctx->priv;
+    AVFrame *in = arg;
+    const int in_channels = s->n_conv; /* number of input channels */
+    const int start = (in_channels * jobnr) / nb_jobs;
+    const int end = (in_channels * (jobnr+1)) / nb_jobs;
+    const int planar = in->format == AV_SAMPLE_FMT_FLTP;
+    const int n_fft = s->n_fft;
+    int i, j;
+
+    for (i = start; i < end; i++) {
+        const float *src = (const float *)in->extended_data[i * planar]; /* get pointer to audio input buffer */
+        float *block = s->temp_fft + i * s->block_size;
+
+        if (i == s->lfe_channel) /* LFE requires no convolution */
+            continue;
+
+        if (planar) {
+            for (j = 0; j < in->nb_samples; j++) {
+                /* write all samples of current input channel to FFT input array */
+                block[j] = src[j];
+            }
+        } else {
+            for (j = 0; j < in->nb_samples; j++) {
+                /* write all samples of current input channel to FFT input array */
+                block[j] = src[j * in_channels + i];
+            }
+        }
+
+        /* fill rest of FFT input with 0 (we want to zero-pad) */
+        memset(block + in->nb_samples, 0, sizeof(*block) * (n_fft - in->nb_samples));
+
+        /* transform input signal of current channel to frequency domain,
+         * move the Nyquist bin behind the complex bins */
+        av_rdft_calc(s->rdft[i], block);
+        block[n_fft] = block[1];
+        block[1] = 0;
+    }
+
+    return 0;
+}
+
 static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     SOFAlizerContext *s = ctx->priv;
@@ -435,7 +480,7 @@ static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     AVFrame *in = td->in, *out = td->out;
     int offset = jobnr;
     int *write = &td->write[jobnr];
-    FFTComplex *hrtf = s->data_hrtf[jobnr]; /* get pointers to current HRTF data */
+    const float *hrtf = s->data_hrtf[jobnr]; /* get pointers to current HRTF data */
     int *n_clippings = &td->n_clippings[jobnr];
     float *ringbuffer = td->ringbuffer[jobnr];
     const int ir_samples = s->sofa.ir_samples; /* length of one IR */
@@ -447,14 +492,11 @@ static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     const int buffer_length = s->buffer_length;
     /* -1 for AND instead of MODULO (applied to powers of 2): */
     const uint32_t modulo = (uint32_t)buffer_length - 1;
-    FFTComplex *fft_in = s->temp_fft[jobnr]; /* temporary array for FFT input/output data */
-    FFTComplex *fft_acc = s->temp_afft[jobnr];
-    FFTContext *ifft = s->ifft[jobnr];
-    FFTContext *fft = s->fft[jobnr];
+    float *fft_acc = s->temp_afft[jobnr];
+    RDFTContext *irdft = s->irdft[jobnr];
     const int n_conv = s->n_conv;
     const int n_fft = s->n_fft;
-    const float fft_scale = 1.0f / s->n_fft;
-    FFTComplex *hrtf_offset;
+    const float fft_scale = 2.0f / s->n_fft;
     int wr = *write;
     int n_read;
     int i, j;
@@ -479,7 +521,7 @@ static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
     }
 
     /* fill FFT accumulation with 0 */
-    memset(fft_acc, 0, sizeof(FFTComplex) * n_fft);
+    memset(fft_acc, 0, sizeof(*fft_acc) * s->block_size);
 
     for (i = 0; i < n_conv; i++) {
         const float *src = (const float *)in->extended_data[i * planar]; /* get pointer to audio input buffer */
@@ -499,57 +541,25 @@ static int sofalizer_fast_convolute(AVFilterContext *ctx, void *arg, int jobnr,
             continue;
         }
 
-        /* outer loop: go through all input channels to be convolved */
-        offset = i * n_fft; /* no. samples already processed */
-        hrtf_offset = hrtf + offset;
-
-        /* fill FFT input with 0 (we want to zero-pad) */
-        memset(fft_in, 0, sizeof(FFTComplex) * n_fft);
-
-        if (in->format == AV_SAMPLE_FMT_FLT) {
-            for (j = 0; j < in->nb_samples; j++) {
-                /* prepare input for FFT */
-                /* write all samples of current input channel to FFT input array */
-                fft_in[j].re = src[j * in_channels + i];
-            }
-        } else {
-            for (j = 0; j < in->nb_samples; j++) {
-                /* prepare input for FFT */
-                /* write all samples of current input channel to FFT input array */
-                fft_in[j].re = src[j];
-            }
-        }
-
-        /* transform input signal of current channel to frequency domain */
-        av_fft_permute(fft, fft_in);
-        av_fft_calc(fft, fft_in);
-        for (j = 0; j < n_fft; j++) {
-            const FFTComplex *hcomplex = hrtf_offset + j;
-            const float re = fft_in[j].re;
-            const float im = fft_in[j].im;
-
-            /* complex multiplication of input signal and HRTFs */
-            /* output channel (real): */
-            fft_acc[j].re += re * hcomplex->re - im * hcomplex->im;
-            /* output channel (imag): */
-            fft_acc[j].im += re * hcomplex->im + im * hcomplex->re;
-        }
+        /* complex multiplication of input signal and HRTFs */
+        s->afirdsp.fcmul_add(fft_acc, s->temp_fft + i * s->block_size,
+                             hrtf + i * s->block_size, n_fft / 2);
     }
 
     /* transform output signal of current channel back to time domain */
-    av_fft_permute(ifft, fft_acc);
-    av_fft_calc(ifft, fft_acc);
+    fft_acc[1] = fft_acc[n_fft];
+    av_rdft_calc(irdft, fft_acc);
 
     for (j = 0; j < in->nb_samples; j++) {
         /* write output signal of current channel to output buffer */
-        dst[mult * j] += fft_acc[j].re * fft_scale;
+        dst[mult * j] += fft_acc[j] * fft_scale;
     }
 
     for (j = 0; j < ir_samples - 1; j++) { /* overflow length is IR length - 1 */
         /* write the rest of output signal to overflow buffer */
         int write_pos = (wr + j) & modulo;
 
-        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j].re * fft_scale;
+        *(ringbuffer + write_pos) += fft_acc[in->nb_samples + j] * fft_scale;
     }
 
     /* go through all samples of current output buffer: count clippings */
@@ -585,12 +595,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     td.in = in; td.out = out; td.write = s->write;
     td.delay = s->delay; td.ir = s->data_ir; td.n_clippings = n_clippings;
     td.ringbuffer = s->ringbuffer; td.temp_src = s->temp_src;
-    td.temp_fft = s->temp_fft;
-    td.temp_afft = s->temp_afft;
 
     if (s->type == TIME_DOMAIN) {
         ctx->internal->execute(ctx, sofalizer_convolute, &td, NULL, 2);
     } else if (s->type == FREQUENCY_DOMAIN) {
+        /* transform each input channel once, both ears share the spectra */
+        ctx->internal->execute(ctx, sofalizer_fft_channels, in, NULL,
+                               FFMIN(s->n_conv, ff_filter_get_nb_threads(ctx)));
         ctx->internal->execute(ctx, sofalizer_fast_convolute, &td, NULL, 2);
     }
     emms_c();
@@ -722,15 +733,15 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
     int n_samples;
     int ir_samples;
     int n_conv = s->n_conv; /* no. channels to convolve */
-    int n_fft;
+    int n_fft, block_size;
     float delay_l; /* broadband delay for each IR */
     float delay_r;
     int nb_input_channels = ctx->inputs[0]->channels; /* no. input channels */
     float gain_lin = expf((s->gain - 3 * nb_input_channels) / 20 * M_LN10); /* gain - 3dB/channel */
-    FFTComplex *data_hrtf_l = NULL;
-    FFTComplex *data_hrtf_r = NULL;
-    FFTComplex *fft_in_l = NULL;
-    FFTComplex *fft_in_r = NULL;
+    float *data_hrtf_l = NULL;
+    float *data_hrtf_r = NULL;
+    float *fft_in_l = NULL;
+    float *fft_in_r = NULL;
     float *data_ir_l = NULL;
     float *data_ir_r = NULL;
     int offset = 0; /* used for faster pointer arithmetics in for-loop */
@@ -831,19 +842,27 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
        (32 - count leading zeros gives required exponent)  */
     s->buffer_length = 1 << (32 - ff_clz(n_max));
     s->n_fft = n_fft = 1 << (32 - ff_clz(n_max + s->framesize));
+    /* rDFT output plus the Nyquist bin, padded for the fcmul_add alignment */
+    s->block_size = block_size = FFALIGN(n_fft + 1, 16);
 
     if (s->type == FREQUENCY_DOMAIN) {
-        av_fft_end(s->fft[0]);
-        av_fft_end(s->fft[1]);
-        s->fft[0] = av_fft_init(av_log2(s->n_fft), 0);
-        s->fft[1] = av_fft_init(av_log2(s->n_fft), 0);
-        av_fft_end(s->ifft[0]);
-        av_fft_end(s->ifft[1]);
-        s->ifft[0] = av_fft_init(av_log2(s->n_fft), 1);
-        s->ifft[1] = av_fft_init(av_log2(s->n_fft), 1);
-
-        if (!s->fft[0] || !s->fft[1] || !s->ifft[0] || !s->ifft[1]) {
-            av_log(ctx, AV_LOG_ERROR, "Unable to create FFT contexts of size %d.\n", s->n_fft);
+        s->rdft = av_calloc(n_conv, sizeof(*s->rdft));
+        if (!s->rdft) {
+            ret = AVERROR(ENOMEM);
+            goto fail;
+        }
+        s->nb_rdft = n_conv;
+
+        for (i = 0; i < n_conv; i++) {
+            s->rdft[i] = av_rdft_init(av_log2(s->n_fft), DFT_R2C);
+            if (!s->rdft[i])
+                break;
+        }
+        s->irdft[0] = av_rdft_init(av_log2(s->n_fft), IDFT_C2R);
+        s->irdft[1] = av_rdft_init(av_log2(s->n_fft), IDFT_C2R);
+
+        if (i < n_conv || !s->irdft[0] || !s->irdft[1]) {
+            av_log(ctx, AV_LOG_ERROR, "Unable to create RDFT contexts of size %d.\n", s->n_fft);
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -854,8 +873,8 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float) * nb_input_channels);
     } else if (s->type == FREQUENCY_DOMAIN) {
         /* get temporary HRTF memory for L and R channel */
-        data_hrtf_l = av_malloc_array(n_fft, sizeof(*data_hrtf_l) * n_conv);
-        data_hrtf_r = av_malloc_array(n_fft, sizeof(*data_hrtf_r) * n_conv);
+        data_hrtf_l = av_malloc_array(block_size, sizeof(*data_hrtf_l) * n_conv);
+        data_hrtf_r = av_malloc_array(block_size, sizeof(*data_hrtf_r) * n_conv);
         if (!data_hrtf_r || !data_hrtf_l) {
             ret = AVERROR(ENOMEM);
             goto fail;
@@ -863,12 +882,10 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
 
         s->ringbuffer[0] = av_calloc(s->buffer_length, sizeof(float));
         s->ringbuffer[1] = av_calloc(s->buffer_length, sizeof(float));
-        s->temp_fft[0] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_fft[1] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[0] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        s->temp_afft[1] = av_malloc_array(s->n_fft, sizeof(FFTComplex));
-        if (!s->temp_fft[0] || !s->temp_fft[1] ||
-            !s->temp_afft[0] || !s->temp_afft[1]) {
+        s->temp_fft = av_calloc(block_size, sizeof(float) * n_conv);
+        s->temp_afft[0] = av_malloc_array(block_size, sizeof(float));
+        s->temp_afft[1] = av_malloc_array(block_size, sizeof(float));
+        if (!s->temp_fft || !s->temp_afft[0] || !s->temp_afft[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
@@ -880,8 +897,8 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
     }
 
     if (s->type == FREQUENCY_DOMAIN) {
-        fft_in_l = av_calloc(n_fft, sizeof(*fft_in_l));
-        fft_in_r = av_calloc(n_fft, sizeof(*fft_in_r));
+        fft_in_l = av_calloc(block_size, sizeof(*fft_in_l));
+        fft_in_r = av_calloc(block_size, sizeof(*fft_in_r));
         if (!fft_in_l || !fft_in_r) {
             ret = AVERROR(ENOMEM);
             goto fail;
@@ -904,41 +921,43 @@ static int load_data(AVFilterContext *ctx, int azim, int elev, float radius, int
                 s->data_ir[1][offset + j] = rir[ir_samples - 1 - j] * gain_lin;
             }
         } else if (s->type == FREQUENCY_DOMAIN) {
-            memset(fft_in_l, 0, n_fft * sizeof(*fft_in_l));
-            memset(fft_in_r, 0, n_fft * sizeof(*fft_in_r));
+            memset(fft_in_l, 0, block_size * sizeof(*fft_in_l));
+            memset(fft_in_r, 0, block_size * sizeof(*fft_in_r));
 
-            offset = i * n_fft; /* no. samples already written */
+            offset = i * block_size; /* no. samples already written */
             for (j = 0; j < ir_samples; j++) {
                 /* load non-reversed IRs of the specified source position
                  * sample-by-sample and apply gain,
-                 * L channel is loaded to real part, R channel to imag part,
                  * IRs are shifted by L and R delay */
-                fft_in_l[s->delay[0][i] + j].re = lir[j] * gain_lin;
-                fft_in_r[s->delay[1][i] + j].re = rir[j] * gain_lin;
+                fft_in_l[s->delay[0][i] + j] = lir[j] * gain_lin;
+                fft_in_r[s->delay[1][i] + j] = rir[j] * gain_lin;
             }
 
-            /* actually transform to frequency domain (IRs -> HRTFs) */
-            av_fft_permute(s->fft[0], fft_in_l);
-            av_fft_calc(s->fft[0], fft_in_l);
-            memcpy(data_hrtf_l + offset, fft_in_l, n_fft * sizeof(*fft_in_l));
-            av_fft_permute(s->fft[0], fft_in_r);
-            av_fft_calc(s->fft[0], fft_in_r);
-            memcpy(data_hrtf_r + offset, fft_in_r, n_fft * sizeof(*fft_in_r));
+            /* actually transform to frequency domain (IRs -> HRTFs),
+             * move the Nyquist bin behind the complex bins */
+            av_rdft_calc(s->rdft[0], fft_in_l);
+            fft_in_l[n_fft] = fft_in_l[1];
+            fft_in_l[1] = 0;
+            memcpy(data_hrtf_l + offset, fft_in_l, block_size * sizeof(*fft_in_l));
+            av_rdft_calc(s->rdft[0], fft_in_r);
+            fft_in_r[n_fft] = fft_in_r[1];
+            fft_in_r[1] = 0;
+            memcpy(data_hrtf_r + offset, fft_in_r, block_size * sizeof(*fft_in_r));
         }
     }
 
     if (s->type == FREQUENCY_DOMAIN) {
-        s->data_hrtf[0] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
-        s->data_hrtf[1] = av_malloc_array(n_fft * s->n_conv, sizeof(FFTComplex));
+        s->data_hrtf[0] = av_malloc_array(block_size * s->n_conv, sizeof(float));
+        s->data_hrtf[1] = av_malloc_array(block_size * s->n_conv, sizeof(float));
         if (!s->data_hrtf[0] || !s->data_hrtf[1]) {
             ret = AVERROR(ENOMEM);
             goto fail;
         }
 
         memcpy(s->data_hrtf[0], data_hrtf_l, /* copy HRTF data to */
-            sizeof(FFTComplex) * n_conv * n_fft); /* filter struct */
+            sizeof(float) * n_conv * block_size); /* filter struct */
         memcpy(s->data_hrtf[1], data_hrtf_r,
-            sizeof(FFTComplex) * n_conv * n_fft);
+            sizeof(float) * n_conv * block_size);
     }
 
 fail:
@@ -981,6 +1000,7 @@ static av_cold int init(AVFilterContext *ctx)
     s->fdsp = avpriv_float_dsp_alloc(0);
     if (!s->fdsp)
         return AVERROR(ENOMEM);
+    ff_afir_init(&s->afirdsp);
 
     return 0;
 }
@@ -1012,16 +1032,17 @@ static int config_input(AVFilterLink *inlink)
 static av_cold void uninit(AVFilterContext *ctx)
 {
     SOFAlizerContext *s = ctx->priv;
+    int i;
 
     close_sofa(&s->sofa);
-    av_fft_end(s->ifft[0]);
-    av_fft_end(s->ifft[1]);
-    av_fft_end(s->fft[0]);
-    av_fft_end(s->fft[1]);
-    s->ifft[0] = NULL;
-    s->ifft[1] = NULL;
-    s->fft[0] = NULL;
-    s->fft[1] = NULL;
+    for (i = 0; i < s->nb_rdft; i++)
+        av_rdft_end(s->rdft[i]);
+    av_freep(&s->rdft);
+    s->nb_rdft = 0;
+    av_rdft_end(s->irdft[0]);
+    av_rdft_end(s->irdft[1]);
+    s->irdft[0] = NULL;
+    s->irdft[1] = NULL;
     av_freep(&s->delay[0]);
     av_freep(&s->delay[1]);
     av_freep(&s->data_ir[0]);
@@ -1034,8 +1055,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->temp_src[1]);
     av_freep(&s->temp_afft[0]);
     av_freep(&s->temp_afft[1]);
-    av_freep(&s->temp_fft[0]);
-    av_freep(&s->temp_fft[1]);
+    av_freep(&s->temp_fft);
     av_freep(&s->data_hrtf[0]);
     av_freep(&s->data_hrtf[1]);
     av_freep(&s->fdsp);
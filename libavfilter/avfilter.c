@@ -24,6 +24,7 @@
 #include "libavutil/buffer.h"
 #include "libavutil/channel_layout.h"
 #include "libavutil/common.h"
+#include "libavutil/cpu.h"
 #include "libavutil/eval.h"
 #include "libavutil/hwcontext.h"
 #include "libavutil/imgutils.h"
@@ -723,6 +724,11 @@ static void free_link(AVFilterLink *link)
     if (!link)
         return;
 
+    if (link->bytes_copied && link->dst)
+        av_log(link->dst, AV_LOG_VERBOSE,
+               "%"PRId64" bytes copied on input '%s' to assemble frames\n",
+               link->bytes_copied, link->dstpad->name);
+
     if (link->src)
         link->src->outputs[link->srcpad - link->src->output_pads] = NULL;
     if (link->dst)
@@ -788,6 +794,13 @@ int ff_filter_get_nb_threads(AVFilterContext *ctx)
     return ctx->graph->nb_threads;
 }
 
+int ff_filter_execute_is_concurrent(AVFilterContext *ctx)
+{
+    return ctx->thread_type & AVFILTER_THREAD_SLICE &&
+           ctx->graph->internal->thread &&
+           ctx->internal->execute == ctx->graph->internal->thread_execute;
+}
+
 static int process_options(AVFilterContext *ctx, AVDictionary **options,
                            const char *args)
 {
@@ -1130,6 +1143,23 @@ static int samples_ready(AVFilterLink *link, unsigned min)
             link->status_in);
 }
 
+/**
+ * Check if the samples of a frame can be passed on without a copy.
+ * Once samples have been skipped, the data pointers of the frame may have
+ * lost the alignment filters rely on.
+ */
+static int samples_aligned(AVFilterLink *link, const AVFrame *frame)
+{
+    int planes = av_sample_fmt_is_planar(link->format) ? link->channels : 1;
+    uintptr_t align = av_cpu_max_align() - 1;
+    int i;
+
+    for (i = 0; i < planes; i++)
+        if ((uintptr_t)frame->extended_data[i] & align)
+            return 0;
+    return 1;
+}
+
 static int take_samples(AVFilterLink *link, unsigned min, unsigned max,
                         AVFrame **rframe)
 {
@@ -1141,7 +1171,8 @@ static int take_samples(AVFilterLink *link, unsigned min, unsigned max,
        called with enough samples. */
     av_assert1(samples_ready(link, link->min_samples));
     frame0 = frame = ff_framequeue_peek(&link->fifo, 0);
-    if (!link->fifo.samples_skipped && frame->nb_samples >= min && frame->nb_samples <= max) {
+    if ((!link->fifo.samples_skipped || samples_aligned(link, frame)) &&
+        frame->nb_samples >= min && frame->nb_samples <= max) {
         *rframe = ff_framequeue_take(&link->fifo);
         return 0;
     }
@@ -1160,6 +1191,17 @@ static int take_samples(AVFilterLink *link, unsigned min, unsigned max,
         frame = ff_framequeue_peek(&link->fifo, nb_frames);
     }
 
+    if (!nb_frames && samples_aligned(link, frame0)) {
+        /* The samples are the start of the first frame: reference them. */
+        buf = av_frame_clone(frame0);
+        if (!buf)
+            return AVERROR(ENOMEM);
+        buf->nb_samples = nb_samples;
+        ff_framequeue_skip_samples(&link->fifo, nb_samples, link->time_base);
+        *rframe = buf;
+        return 0;
+    }
+
     buf = ff_get_audio_buffer(link, nb_samples);
     if (!buf)
         return AVERROR(ENOMEM);
@@ -1185,6 +1227,8 @@ static int take_samples(AVFilterLink *link, unsigned min, unsigned max,
                         link->channels, link->format);
         ff_framequeue_skip_samples(&link->fifo, n, link->time_base);
     }
+    link->bytes_copied += av_samples_get_buffer_size(NULL, link->channels, nb_samples,
+                                                     link->format, 1);
 
     *rframe = buf;
     return 0;
@@ -582,6 +582,12 @@ struct AVFilterLink {
      */
     int64_t frame_count_in, frame_count_out;
 
+    /**
+     * Number of sample bytes copied to assemble frames of the size requested
+     * by min_samples/max_samples.
+     */
+    int64_t bytes_copied;
+
     /**
      * A pointer to a FFFramePool struct.
      */
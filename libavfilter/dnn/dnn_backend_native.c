@@ -38,7 +38,7 @@ static DNNReturnType get_input_native(void *model, DNNData *input, const char *i
             if (oprd->type != DOT_INPUT)
                 return DNN_ERROR;
             input->dt = oprd->data_type;
-            av_assert0(oprd->dims[0] == 1);
+            input->batch_size = 1;
             input->height = oprd->dims[1];
             input->width = oprd->dims[2];
             input->channels = oprd->dims[3];
@@ -72,7 +72,7 @@ static DNNReturnType set_input_output_native(void *model, DNNData *input, const
     if (!oprd)
         return DNN_ERROR;
 
-    oprd->dims[0] = 1;
+    oprd->dims[0] = FFMAX(input->batch_size, 1);
     oprd->dims[1] = input->height;
     oprd->dims[2] = input->width;
     oprd->dims[3] = input->channels;
@@ -113,7 +113,7 @@ static DNNReturnType set_input_output_native(void *model, DNNData *input, const
 // layers_num,layer_type,layer_parameterss,layer_type,layer_parameters...
 // For CONV layer: activation_function, input_num, output_num, kernel_size, kernel, biases
 // For DEPTH_TO_SPACE layer: block_size
-DNNModel *ff_dnn_load_model_native(const char *model_filename)
+DNNModel *ff_dnn_load_model_native(const char *model_filename, int nb_threads)
 {
     DNNModel *model = NULL;
     char header_expected[] = "FFMPEGDNNNATIVE";
@@ -180,6 +180,12 @@ DNNModel *ff_dnn_load_model_native(const char *model_filename)
     }
     model->model = (void *)network;
 
+    if (dnn_native_init_context(&network->ctx, nb_threads) < 0) {
+        avio_closep(&model_file_context);
+        ff_dnn_free_model_native(&model);
+        return NULL;
+    }
+
     avio_seek(model_file_context, file_size - 8, SEEK_SET);
     network->layers_num = (int32_t)avio_rl32(model_file_context);
     network->operands_num = (int32_t)avio_rl32(model_file_context);
@@ -273,15 +279,17 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *output
 
     for (layer = 0; layer < network->layers_num; ++layer){
         DNNLayerType layer_type = network->layers[layer].type;
-        layer_funcs[layer_type].pf_exec(network->operands,
-                                  network->layers[layer].input_operand_indexes,
-                                  network->layers[layer].output_operand_index,
-                                  network->layers[layer].params);
+        if (layer_funcs[layer_type].pf_exec(&network->ctx, network->operands,
+                                            network->layers[layer].input_operand_indexes,
+                                            network->layers[layer].output_operand_index,
+                                            network->layers[layer].params) < 0)
+            return DNN_ERROR;
     }
 
     for (uint32_t i = 0; i < nb; ++i) {
         DnnOperand *oprd = &network->operands[network->output_indexes[i]];
         outputs[i].data = oprd->data;
+        outputs[i].batch_size = oprd->dims[0];
         outputs[i].height = oprd->dims[1];
         outputs[i].width = oprd->dims[2];
         outputs[i].channels = oprd->dims[3];
@@ -291,6 +299,54 @@ DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *output
     return DNN_SUCCESS;
 }
 
+static void native_worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    NativeContext *ctx = priv;
+    ctx->job(ctx->job_arg, jobnr, threadnr);
+}
+
+int dnn_native_init_context(NativeContext *ctx, int nb_threads)
+{
+    int ret;
+
+    ctx->fdsp = avpriv_float_dsp_alloc(0);
+    if (!ctx->fdsp)
+        return AVERROR(ENOMEM);
+
+    ctx->nb_threads = 1;
+    if (nb_threads > 1) {
+        ret = avpriv_slicethread_create(&ctx->thread, ctx, native_worker_func, NULL, nb_threads);
+        if (ret > 1)
+            ctx->nb_threads = ret;
+        else
+            avpriv_slicethread_free(&ctx->thread);
+    }
+
+    return 0;
+}
+
+void dnn_native_uninit_context(NativeContext *ctx)
+{
+    avpriv_slicethread_free(&ctx->thread);
+    av_freep(&ctx->fdsp);
+    av_freep(&ctx->conv_scratch);
+    ctx->conv_scratch_size = 0;
+    ctx->nb_threads = 0;
+}
+
+void dnn_native_execute(NativeContext *ctx, void (*job)(void *arg, int jobnr, int threadnr),
+                        void *arg, int nb_jobs)
+{
+    if (ctx->thread && nb_jobs > 1) {
+        ctx->job     = job;
+        ctx->job_arg = arg;
+        avpriv_slicethread_execute(ctx->thread, nb_jobs, 0);
+    } else {
+        for (int i = 0; i < nb_jobs; i++)
+            job(arg, i, 0);
+    }
+}
+
 int32_t calculate_operand_dims_count(const DnnOperand *oprd)
 {
     int32_t result = 1;
@@ -330,6 +386,7 @@ void ff_dnn_free_model_native(DNNModel **model)
         av_freep(&network->operands);
 
         av_freep(&network->output_indexes);
+        dnn_native_uninit_context(&network->ctx);
         av_freep(&network);
         av_freep(model);
     }
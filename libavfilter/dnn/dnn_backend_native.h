@@ -29,6 +29,8 @@
 
 #include "../dnn_interface.h"
 #include "libavformat/avio.h"
+#include "libavutil/float_dsp.h"
+#include "libavutil/slicethread.h"
 
 /**
  * the enum value of DNNLayerType should not be changed,
@@ -102,8 +104,26 @@ typedef struct InputParams{
     int height, width, channels;
 } InputParams;
 
+/**
+ * execution state shared by all layers of a network.
+ * the thread pool is optional, layers fall back to running
+ * their jobs in the calling thread when it is NULL.
+ */
+typedef struct NativeContext{
+    AVFloatDSPContext *fdsp;
+    AVSliceThread *thread;
+    int nb_threads;
+
+    float *conv_scratch;                ///< per-thread conv2d row buffers
+    unsigned int conv_scratch_size;
+
+    void (*job)(void *arg, int jobnr, int threadnr);
+    void *job_arg;
+} NativeContext;
+
 // Represents simple feed-forward convolutional network.
 typedef struct ConvolutionalNetwork{
+    NativeContext ctx;
     Layer *layers;
     int32_t layers_num;
     DnnOperand *operands;
@@ -112,12 +132,29 @@ typedef struct ConvolutionalNetwork{
     uint32_t nb_output;
 } ConvolutionalNetwork;
 
-DNNModel *ff_dnn_load_model_native(const char *model_filename);
+DNNModel *ff_dnn_load_model_native(const char *model_filename, int nb_threads);
 
 DNNReturnType ff_dnn_execute_model_native(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
 
 void ff_dnn_free_model_native(DNNModel **model);
 
+/**
+ * Set up the float DSP functions and the thread pool of a context.
+ *
+ * @param nb_threads number of threads to use
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int dnn_native_init_context(NativeContext *ctx, int nb_threads);
+
+void dnn_native_uninit_context(NativeContext *ctx);
+
+/**
+ * Run nb_jobs invocations of job, spread over the threads of the context.
+ * threadnr is in the range [0, ctx->nb_threads).
+ */
+void dnn_native_execute(NativeContext *ctx, void (*job)(void *arg, int jobnr, int threadnr),
+                        void *arg, int nb_jobs);
+
 int32_t calculate_operand_data_length(const DnnOperand *oprd);
 int32_t calculate_operand_dims_count(const DnnOperand *oprd);
 #endif
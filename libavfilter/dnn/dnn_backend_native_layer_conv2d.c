@@ -83,22 +83,132 @@ int dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int fil
     return dnn_size;
 }
 
-int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_indexes,
+typedef struct ConvThreadData {
+    NativeContext *ctx;
+    const ConvolutionalParams *params;
+    const float *input;
+    float *output;
+    int height, width;
+    int output_height, output_width;
+    int pad_size;
+    /* row length of the planar scratch buffers, padded for the float dsp */
+    int stride;
+    float *scratch;
+    int scratch_size;
+    int nb_jobs;
+} ConvThreadData;
+
+static float activate(DNNActivationFunc activation, float x)
+{
+    switch (activation) {
+    case RELU:
+        return FFMAX(x, 0.0);
+    case TANH:
+        return 2.0f / (1.0f + exp(-2.0f * x)) - 1.0f;
+    case SIGMOID:
+        return 1.0f / (1.0f + exp(-x));
+    case LEAKY_RELU:
+        return FFMAX(x, 0.0) + 0.2 * FFMIN(x, 0.0);
+    case NONE:
+    default:
+        return x;
+    }
+}
+
+/**
+ * Compute a band of output rows. Each output row is accumulated in a
+ * planar [output_num][stride] buffer; for every kernel row and input
+ * channel the input line is expanded into kernel_size shifted copies
+ * (with edge handling applied), so that the innermost loop is a plain
+ * multiply-accumulate of a whole row by a scalar kernel tap.
+ */
+static void conv2d_rows(void *arg, int jobnr, int threadnr)
+{
+    const ConvThreadData *td = arg;
+    const ConvolutionalParams *conv_params = td->params;
+    AVFloatDSPContext *fdsp = td->ctx->fdsp;
+    const int kernel_size = conv_params->kernel_size;
+    const int input_num = conv_params->input_num;
+    const int output_num = conv_params->output_num;
+    const int dilation = conv_params->dilation;
+    const int radius = kernel_size >> 1;
+    const int src_linesize = td->width * input_num;
+    const int filter_linesize = kernel_size * input_num;
+    const int filter_size = kernel_size * filter_linesize;
+    const int stride = td->stride;
+    const int slice_start = (td->output_height * jobnr) / td->nb_jobs;
+    const int slice_end = (td->output_height * (jobnr + 1)) / td->nb_jobs;
+    float *acc = td->scratch + threadnr * td->scratch_size;
+    float *shifted = acc + output_num * stride;
+
+    for (int yo = slice_start; yo < slice_end; ++yo) {
+        const int y = yo + td->pad_size;
+        float *output = td->output + yo * td->output_width * output_num;
+
+        for (int n_filter = 0; n_filter < output_num; ++n_filter) {
+            float bias = conv_params->has_bias ? conv_params->biases[n_filter] : 0.f;
+            float *dst = acc + n_filter * stride;
+            for (int x = 0; x < td->output_width; ++x)
+                dst[x] = bias;
+            /* keep the padding up to stride finite, the buffer is reused */
+            for (int x = td->output_width; x < stride; ++x)
+                dst[x] = 0.f;
+        }
+
+        for (int kernel_y = 0; kernel_y < kernel_size; ++kernel_y) {
+            int y_pos = y + (kernel_y - radius) * dilation;
+            const float *src;
+
+            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE)
+                y_pos = CLAMP_TO_EDGE(y_pos, td->height);
+            else if (y_pos < 0 || y_pos >= td->height)
+                continue;
+            src = td->input + y_pos * src_linesize;
+
+            for (int ch = 0; ch < input_num; ++ch) {
+                for (int kernel_x = 0; kernel_x < kernel_size; ++kernel_x) {
+                    float *dst = shifted + kernel_x * stride;
+                    for (int xo = 0; xo < td->output_width; ++xo) {
+                        int x_pos = xo + td->pad_size + (kernel_x - radius) * dilation;
+                        if (conv_params->padding_method == SAME_CLAMP_TO_EDGE)
+                            dst[xo] = src[CLAMP_TO_EDGE(x_pos, td->width) * input_num + ch];
+                        else
+                            dst[xo] = (x_pos < 0 || x_pos >= td->width) ? 0.f : src[x_pos * input_num + ch];
+                    }
+                    for (int xo = td->output_width; xo < stride; ++xo)
+                        dst[xo] = 0.f;
+                }
+
+                for (int n_filter = 0; n_filter < output_num; ++n_filter) {
+                    const float *kernel = conv_params->kernel + n_filter * filter_size +
+                                          kernel_y * filter_linesize + ch;
+                    for (int kernel_x = 0; kernel_x < kernel_size; ++kernel_x)
+                        fdsp->vector_fmac_scalar(acc + n_filter * stride, shifted + kernel_x * stride,
+                                                 kernel[kernel_x * input_num], stride);
+                }
+            }
+        }
+
+        for (int x = 0; x < td->output_width; ++x) {
+            for (int n_filter = 0; n_filter < output_num; ++n_filter)
+                output[n_filter] = activate(conv_params->activation, acc[n_filter * stride + x]);
+            output += output_num;
+        }
+    }
+}
+
+int dnn_execute_layer_conv2d(NativeContext *ctx, DnnOperand *operands,
+                             const int32_t *input_operand_indexes,
                              int32_t output_operand_index, const void *parameters)
 {
-    float *output;
+    ConvThreadData td;
     int32_t input_operand_index = input_operand_indexes[0];
     int number = operands[input_operand_index].dims[0];
     int height = operands[input_operand_index].dims[1];
     int width = operands[input_operand_index].dims[2];
     int channel = operands[input_operand_index].dims[3];
-    const float *input = operands[input_operand_index].data;
     const ConvolutionalParams *conv_params = (const ConvolutionalParams *)parameters;
 
-    int radius = conv_params->kernel_size >> 1;
-    int src_linesize = width * conv_params->input_num;
-    int filter_linesize = conv_params->kernel_size * conv_params->input_num;
-    int filter_size = conv_params->kernel_size * filter_linesize;
     int pad_size = (conv_params->padding_method == VALID) ? (conv_params->kernel_size - 1) / 2 * conv_params->dilation : 0;
 
     DnnOperand *output_operand = &operands[output_operand_index];
@@ -111,57 +221,36 @@ int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_
     output_operand->data = av_realloc(output_operand->data, output_operand->length);
     if (!output_operand->data)
         return -1;
-    output = output_operand->data;
 
     av_assert0(channel == conv_params->input_num);
 
-    for (int y = pad_size; y < height - pad_size; ++y) {
-        for (int x = pad_size; x < width - pad_size; ++x) {
-            for (int n_filter = 0; n_filter < conv_params->output_num; ++n_filter) {
-                if (conv_params->has_bias)
-                    output[n_filter] = conv_params->biases[n_filter];
-                else
-                    output[n_filter] = 0.f;
-
-                for (int ch = 0; ch < conv_params->input_num; ++ch) {
-                    for (int kernel_y = 0; kernel_y < conv_params->kernel_size; ++kernel_y) {
-                        for (int kernel_x = 0; kernel_x < conv_params->kernel_size; ++kernel_x) {
-                            float input_pel;
-                            if (conv_params->padding_method == SAME_CLAMP_TO_EDGE) {
-                                int y_pos = CLAMP_TO_EDGE(y + (kernel_y - radius) * conv_params->dilation, height);
-                                int x_pos = CLAMP_TO_EDGE(x + (kernel_x - radius) * conv_params->dilation, width);
-                                input_pel = input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            } else {
-                                int y_pos = y + (kernel_y - radius) * conv_params->dilation;
-                                int x_pos = x + (kernel_x - radius) * conv_params->dilation;
-                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
-                                                   input[y_pos * src_linesize + x_pos * conv_params->input_num + ch];
-                            }
-
-
-                            output[n_filter] += input_pel * conv_params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
-                                                                                kernel_x * conv_params->input_num + ch];
-                        }
-                    }
-                }
-                switch (conv_params->activation){
-                case RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0);
-                    break;
-                case TANH:
-                    output[n_filter] = 2.0f  / (1.0f + exp(-2.0f * output[n_filter])) - 1.0f;
-                    break;
-                case SIGMOID:
-                    output[n_filter] = 1.0f / (1.0f + exp(-output[n_filter]));
-                    break;
-                case NONE:
-                    break;
-                case LEAKY_RELU:
-                    output[n_filter] = FFMAX(output[n_filter], 0.0) + 0.2 * FFMIN(output[n_filter], 0.0);
-                }
-            }
-            output += conv_params->output_num;
-        }
+    td.ctx = ctx;
+    td.params = conv_params;
+    td.height = height;
+    td.width = width;
+    td.output_height = output_operand->dims[1];
+    td.output_width = output_operand->dims[2];
+    td.pad_size = pad_size;
+    if (td.output_height <= 0 || td.output_width <= 0)
+        return 0;
+
+    td.stride = FFALIGN(td.output_width, 16);
+    td.scratch_size = (conv_params->output_num + conv_params->kernel_size) * td.stride;
+    td.nb_jobs = FFMIN(td.output_height, ctx->nb_threads);
+    if (td.scratch_size > INT_MAX / sizeof(float) / ctx->nb_threads)
+        return -1;
+    av_fast_malloc(&ctx->conv_scratch, &ctx->conv_scratch_size,
+                   ctx->nb_threads * td.scratch_size * sizeof(float));
+    if (!ctx->conv_scratch)
+        return -1;
+    td.scratch = ctx->conv_scratch;
+
+    for (int n = 0; n < number; n++) {
+        td.input = (const float *)operands[input_operand_index].data + n * height * width * channel;
+        td.output = (float *)output_operand->data +
+                    n * td.output_height * td.output_width * conv_params->output_num;
+        dnn_native_execute(ctx, conv2d_rows, &td, td.nb_jobs);
     }
+
     return 0;
 }
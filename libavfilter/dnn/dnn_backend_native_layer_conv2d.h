@@ -37,6 +37,7 @@ typedef struct ConvolutionalParams{
 } ConvolutionalParams;
 
 int dnn_load_layer_conv2d(Layer *layer, AVIOContext *model_file_context, int file_size);
-int dnn_execute_layer_conv2d(DnnOperand *operands, const int32_t *input_operand_indexes,
+int dnn_execute_layer_conv2d(NativeContext *ctx, DnnOperand *operands,
+                             const int32_t *input_operand_indexes,
                              int32_t output_operand_index, const void *parameters);
 #endif
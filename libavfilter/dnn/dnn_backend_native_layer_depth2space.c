@@ -45,7 +45,8 @@ int dnn_load_layer_depth2space(Layer *layer, AVIOContext *model_file_context, in
     return dnn_size;
 }
 
-int dnn_execute_layer_depth2space(DnnOperand *operands, const int32_t *input_operand_indexes,
+int dnn_execute_layer_depth2space(NativeContext *ctx, DnnOperand *operands,
+                                  const int32_t *input_operand_indexes,
                                   int32_t output_operand_index, const void *parameters)
 {
     float *output;
@@ -76,7 +77,8 @@ int dnn_execute_layer_depth2space(DnnOperand *operands, const int32_t *input_ope
         return -1;
     output = output_operand->data;
 
-    for (y = 0; y < height; ++y){
+    // images of a batch are stored back to back, so they can be handled as one tall image
+    for (y = 0; y < number * height; ++y){
         for (x = 0; x < width; ++x){
             for (by = 0; by < block_size; ++by){
                 for (bx = 0; bx < block_size; ++bx){
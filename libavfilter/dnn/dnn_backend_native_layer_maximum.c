@@ -45,7 +45,8 @@ int dnn_load_layer_maximum(Layer *layer, AVIOContext *model_file_context, int fi
     return dnn_size;
 }
 
-int dnn_execute_layer_maximum(DnnOperand *operands, const int32_t *input_operand_indexes,
+int dnn_execute_layer_maximum(NativeContext *ctx, DnnOperand *operands,
+                              const int32_t *input_operand_indexes,
                               int32_t output_operand_index, const void *parameters)
 {
     const DnnOperand *input = &operands[input_operand_indexes[0]];
@@ -37,7 +37,8 @@ typedef struct LayerPadParams{
 } LayerPadParams;
 
 int dnn_load_layer_pad(Layer *layer, AVIOContext *model_file_context, int file_size);
-int dnn_execute_layer_pad(DnnOperand *operands, const int32_t *input_operand_indexes,
+int dnn_execute_layer_pad(NativeContext *ctx, DnnOperand *operands,
+                          const int32_t *input_operand_indexes,
                           int32_t output_operand_index, const void *parameters);
 
 #endif
@@ -24,7 +24,7 @@
 #include <stdint.h>
 #include "dnn_backend_native.h"
 
-typedef int (*LAYER_EXEC_FUNC)(DnnOperand *operands, const int32_t *input_operand_indexes,
+typedef int (*LAYER_EXEC_FUNC)(NativeContext *ctx, DnnOperand *operands, const int32_t *input_operand_indexes,
                                int32_t output_operand_index, const void *parameters);
 typedef int (*LAYER_LOAD_FUNC)(Layer *layer, AVIOContext *model_file_context, int file_size);
 
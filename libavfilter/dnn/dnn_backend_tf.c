@@ -87,7 +87,7 @@ static TF_Tensor *allocate_input_tensor(const DNNData *input)
 {
     TF_DataType dt;
     size_t size;
-    int64_t input_dims[] = {1, input->height, input->width, input->channels};
+    int64_t input_dims[] = {FFMAX(input->batch_size, 1), input->height, input->width, input->channels};
     switch (input->dt) {
     case DNN_FLOAT:
         dt = TF_FLOAT;
@@ -102,7 +102,7 @@ static TF_Tensor *allocate_input_tensor(const DNNData *input)
     }
 
     return TF_AllocateTensor(dt, input_dims, 4,
-                             input_dims[1] * input_dims[2] * input_dims[3] * size);
+                             input_dims[0] * input_dims[1] * input_dims[2] * input_dims[3] * size);
 }
 
 static DNNReturnType get_input_tf(void *model, DNNData *input, const char *input_name)
@@ -127,8 +127,9 @@ static DNNReturnType get_input_tf(void *model, DNNData *input, const char *input
     }
     TF_DeleteStatus(status);
 
-    // currently only NHWC is supported
-    av_assert0(dims[0] == 1);
+    // currently only NHWC is supported, the batch dimension may be left open
+    av_assert0(dims[0] == 1 || dims[0] == -1);
+    input->batch_size = 1;
     input->height = dims[1];
     input->width = dims[2];
     input->channels = dims[3];
@@ -485,12 +486,12 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     TF_Output input;
     int32_t *transpose_perm;
     int64_t transpose_perm_shape[] = {4};
-    int64_t input_shape[] = {1, -1, -1, -1};
+    int64_t input_shape[] = {-1, -1, -1, -1};
     DNNReturnType layer_add_res;
     DNNModel *native_model = NULL;
     ConvolutionalNetwork *conv_network;
 
-    native_model = ff_dnn_load_model_native(model_filename);
+    native_model = ff_dnn_load_model_native(model_filename, 1);
     if (!native_model){
         return DNN_ERROR;
     }
@@ -572,7 +573,7 @@ static DNNReturnType load_native_model(TFModel *tf_model, const char *model_file
     return DNN_SUCCESS;
 }
 
-DNNModel *ff_dnn_load_model_tf(const char *model_filename)
+DNNModel *ff_dnn_load_model_tf(const char *model_filename, int nb_threads)
 {
     DNNModel *model = NULL;
     TFModel *tf_model = NULL;
@@ -631,6 +632,7 @@ DNNReturnType ff_dnn_execute_model_tf(const DNNModel *model, DNNData *outputs, u
     }
 
     for (uint32_t i = 0; i < nb; ++i) {
+        outputs[i].batch_size = TF_Dim(tf_model->output_tensors[i], 0);
         outputs[i].height = TF_Dim(tf_model->output_tensors[i], 1);
         outputs[i].width = TF_Dim(tf_model->output_tensors[i], 2);
         outputs[i].channels = TF_Dim(tf_model->output_tensors[i], 3);
@@ -38,6 +38,8 @@ typedef struct DNNData{
     void *data;
     DNNDataType dt;
     int width, height, channels;
+    // number of frames stored back to back in data, 0 is the same as 1
+    int batch_size;
 } DNNData;
 
 typedef struct DNNModel{
@@ -54,7 +56,8 @@ typedef struct DNNModel{
 // Stores pointers to functions for loading, executing, freeing DNN models for one of the backends.
 typedef struct DNNModule{
     // Loads model and parameters from given file. Returns NULL if it is not possible.
-    DNNModel *(*load_model)(const char *model_filename);
+    // nb_threads is the number of threads the backend may use to execute the model.
+    DNNModel *(*load_model)(const char *model_filename, int nb_threads);
     // Executes model with specified input and output. Returns DNN_ERROR otherwise.
     DNNReturnType (*execute_model)(const DNNModel *model, DNNData *outputs, uint32_t nb_output);
     // Frees memory allocated for model.
@@ -46,6 +46,7 @@
 #include <float.h>
 #include <limits.h>
 #include <math.h>               /* You may have to define _USE_MATH_DEFINES if you use MSVC */
+#include <string.h>
 
 #include "libavutil/common.h"
 #include "libavutil/mem.h"
@@ -91,6 +92,10 @@ struct FFEBUR128StateInternal {
     size_t short_term_frame_counter;
     /** Maximum sample peak, one per channel */
     double *sample_peak;
+    /** Maximum true peak, one per channel */
+    double *true_peak;
+    /** Oversampling state for true peak metering */
+    FFEBUR128TruePeak *tp;
     /** The maximum window duration in ms. */
     unsigned long window;
     /** Data pointer array for interleaved data */
@@ -101,6 +106,43 @@ static AVOnce histogram_init = AV_ONCE_INIT;
 static DECLARE_ALIGNED(32, double, histogram_energies)[1000];
 static DECLARE_ALIGNED(32, double, histogram_energy_boundaries)[1001];
 
+/* True peak oversampling (ITU-R BS.1770-4 Annex 2): a 49 tap Hann windowed
+ * sinc interpolating by 4, split in 4 polyphase branches of 12 taps. Branch 0
+ * only has its center tap set, so it is the input signal itself and is not
+ * computed. */
+#define TP_PHASES 4
+#define TP_TAPS   12
+#define TP_BLOCK  1024
+
+static AVOnce true_peak_init = AV_ONCE_INIT;
+/* polyphase branches 1 to 3, stored in reverse tap order */
+static DECLARE_ALIGNED(32, double, true_peak_coeffs)[TP_PHASES - 1][TP_TAPS];
+
+struct FFEBUR128TruePeak {
+    unsigned int channels;
+    /** Interpolation factor, 1 (no oversampling), 2 or 4. */
+    int factor;
+    /** Per channel TP_TAPS - 1 samples of history followed by TP_BLOCK input
+     *  samples, so that each branch is a plain dot product. */
+    double *buf;
+};
+
+static void init_true_peak_coeffs(void)
+{
+    int p, k;
+
+    for (p = 1; p < TP_PHASES; p++) {
+        for (k = 0; k < TP_TAPS; k++) {
+            int j = p + k * TP_PHASES;
+            double m = (j - TP_TAPS * TP_PHASES / 2) * M_PI / TP_PHASES;
+            double c = sin(m) / m;
+
+            c *= 0.5 * (1.0 - cos(2.0 * M_PI * j / (TP_TAPS * TP_PHASES)));
+            true_peak_coeffs[p - 1][TP_TAPS - 1 - k] = c;
+        }
+    }
+}
+
 static void ebur128_init_filter(FFEBUR128State * st)
 {
     int i, j;
@@ -279,8 +321,22 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     CHECK_ERROR(!st->d->data_ptrs, 0,
                 free_short_term_block_energy_histogram);
 
+    st->d->true_peak = NULL;
+    st->d->tp        = NULL;
+    if ((mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK) {
+        st->d->true_peak =
+            (double *) av_mallocz_array(channels, sizeof(double));
+        CHECK_ERROR(!st->d->true_peak, 0, free_data_ptrs)
+        st->d->tp = ff_ebur128_true_peak_init(channels, samplerate);
+        CHECK_ERROR(!st->d->tp, 0, free_true_peak)
+    }
+
     return st;
 
+free_true_peak:
+    av_free(st->d->true_peak);
+free_data_ptrs:
+    av_free(st->d->data_ptrs);
 free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
@@ -306,12 +362,128 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->audio_data);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
+    av_free((*st)->d->true_peak);
+    ff_ebur128_true_peak_destroy(&(*st)->d->tp);
     av_free((*st)->d->data_ptrs);
     av_free((*st)->d);
     av_free(*st);
     *st = NULL;
 }
 
+FFEBUR128TruePeak *ff_ebur128_true_peak_init(unsigned int channels,
+                                             unsigned long samplerate)
+{
+    FFEBUR128TruePeak *tp;
+
+    if (ff_thread_once(&true_peak_init, &init_true_peak_coeffs) != 0)
+        return NULL;
+
+    tp = av_mallocz(sizeof(*tp));
+    if (!tp)
+        return NULL;
+    tp->channels = channels;
+    tp->factor   = samplerate < 96000 ? 4 : samplerate < 192000 ? 2 : 1;
+    tp->buf      = av_mallocz_array(channels, (TP_TAPS - 1 + TP_BLOCK) * sizeof(*tp->buf));
+    if (!tp->buf) {
+        av_free(tp);
+        return NULL;
+    }
+    return tp;
+}
+
+void ff_ebur128_true_peak_destroy(FFEBUR128TruePeak **tp)
+{
+    if (!*tp)
+        return;
+    av_free((*tp)->buf);
+    av_freep(tp);
+}
+
+static double true_peak_x4(const double *buf, size_t frames)
+{
+    const double *c1 = true_peak_coeffs[0];
+    const double *c2 = true_peak_coeffs[1];
+    const double *c3 = true_peak_coeffs[2];
+    double peak = 0.0;
+    size_t i;
+    int k;
+
+    for (i = 0; i < frames; i++) {
+        const double *x = buf + i;
+        double s1 = 0.0, s2 = 0.0, s3 = 0.0;
+
+        for (k = 0; k < TP_TAPS; k++) {
+            s1 += c1[k] * x[k];
+            s2 += c2[k] * x[k];
+            s3 += c3[k] * x[k];
+        }
+        peak = FFMAX(peak, fabs(x[TP_TAPS - 1]));
+        peak = FFMAX(peak, fabs(s1));
+        peak = FFMAX(peak, fabs(s2));
+        peak = FFMAX(peak, fabs(s3));
+    }
+    return peak;
+}
+
+static double true_peak_x2(const double *buf, size_t frames)
+{
+    /* the middle branch of the 4x interpolator is the half sample one */
+    const double *c = true_peak_coeffs[1];
+    double peak = 0.0;
+    size_t i;
+    int k;
+
+    for (i = 0; i < frames; i++) {
+        const double *x = buf + i;
+        double s = 0.0;
+
+        for (k = 0; k < TP_TAPS; k++)
+            s += c[k] * x[k];
+        peak = FFMAX(peak, fabs(x[TP_TAPS - 1]));
+        peak = FFMAX(peak, fabs(s));
+    }
+    return peak;
+}
+
+#define EBUR128_TRUE_PEAK(type)                                                    \
+static double ebur128_true_peak_##type(FFEBUR128TruePeak *tp, unsigned int ch,   \
+                                       const type *src, size_t frames,           \
+                                       int stride, double scaling_factor)        \
+{                                                                                \
+    double *buf = tp->buf + ch * (TP_TAPS - 1 + TP_BLOCK);                       \
+    double peak = 0.0;                                                           \
+    size_t i;                                                                    \
+                                                                                 \
+    while (frames > 0) {                                                         \
+        size_t n = FFMIN(frames, TP_BLOCK);                                      \
+                                                                                 \
+        for (i = 0; i < n; i++)                                                  \
+            buf[TP_TAPS - 1 + i] = src[i * stride] / scaling_factor;             \
+        if (tp->factor == 4) {                                                   \
+            peak = FFMAX(peak, true_peak_x4(buf, n));                            \
+        } else if (tp->factor == 2) {                                            \
+            peak = FFMAX(peak, true_peak_x2(buf, n));                            \
+        } else {                                                                 \
+            for (i = 0; i < n; i++)                                              \
+                peak = FFMAX(peak, fabs(buf[TP_TAPS - 1 + i]));                  \
+        }                                                                        \
+        memmove(buf, buf + n, (TP_TAPS - 1) * sizeof(*buf));                     \
+        src    += n * stride;                                                    \
+        frames -= n;                                                             \
+    }                                                                            \
+    return peak;                                                                 \
+}
+EBUR128_TRUE_PEAK(short)
+EBUR128_TRUE_PEAK(int)
+EBUR128_TRUE_PEAK(float)
+EBUR128_TRUE_PEAK(double)
+
+double ff_ebur128_true_peak_add_frames(FFEBUR128TruePeak *tp, unsigned int channel,
+                                       const double *src, size_t frames, int stride)
+{
+    return ebur128_true_peak_double(tp, channel, src, frames, stride, 1.0);
+}
+
 #define EBUR128_FILTER(type, scaling_factor)                                       \
 static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
                                   size_t src_index, size_t frames,                 \
@@ -334,6 +506,14 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
             if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
         }                                                                          \
     }                                                                              \
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK) {     \
+        for (c = 0; c < st->channels; ++c) {                                       \
+            double max = ebur128_true_peak_##type(st->d->tp, c,                    \
+                                                  srcs[c] + src_index, frames,     \
+                                                  stride, scaling_factor);         \
+            if (max > st->d->true_peak[c]) st->d->true_peak[c] = max;              \
+        }                                                                          \
+    }                                                                              \
     for (c = 0; c < st->channels; ++c) {                                           \
         int ci = st->d->channel_map[c] - 1;                                        \
         if (ci < 0) continue;                                                      \
@@ -767,3 +947,16 @@ int ff_ebur128_sample_peak(FFEBUR128State * st,
     *out = st->d->sample_peak[channel_number];
     return 0;
 }
+
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out)
+{
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) !=
+        FF_EBUR128_MODE_TRUE_PEAK) {
+        return AVERROR(EINVAL);
+    } else if (channel_number >= st->channels) {
+        return AVERROR(EINVAL);
+    }
+    *out = st->d->true_peak[channel_number];
+    return 0;
+}
@@ -91,11 +91,16 @@ enum mode {
     FF_EBUR128_MODE_LRA = (1 << 3) | FF_EBUR128_MODE_S,
   /** can call ff_ebur128_sample_peak */
     FF_EBUR128_MODE_SAMPLE_PEAK = (1 << 4) | FF_EBUR128_MODE_M,
+  /** can call ff_ebur128_true_peak */
+    FF_EBUR128_MODE_TRUE_PEAK = (1 << 5) | FF_EBUR128_MODE_SAMPLE_PEAK,
 };
 
 /** forward declaration of FFEBUR128StateInternal */
 struct FFEBUR128StateInternal;
 
+/** Oversampling true peak meter, see ff_ebur128_true_peak_init() */
+typedef struct FFEBUR128TruePeak FFEBUR128TruePeak;
+
 /** \brief Contains information about the state of a loudness measurement.
  *
  *  You should not need to modify this struct directly.
@@ -283,6 +288,56 @@ int ff_ebur128_loudness_range_multiple(FFEBUR128State ** sts,
 int ff_ebur128_sample_peak(FFEBUR128State * st,
                            unsigned int channel_number, double *out);
 
+/** \brief Get maximum true peak of selected channel in float format.
+ *
+ *  The signal is oversampled 4 times below 96 kHz and 2 times below 192 kHz
+ *  as described in ITU-R BS.1770-4 Annex 2. At higher sample rates the true
+ *  peak is the sample peak.
+ *
+ *  @param st library state
+ *  @param channel_number channel to analyse
+ *  @param out maximum true peak in float format (1.0 is 0 dBFS)
+ *  @return
+ *    - 0 on success.
+ *    - AVERROR(EINVAL) if mode "FF_EBUR128_MODE_TRUE_PEAK" has not been set.
+ *    - AVERROR(EINVAL) if invalid channel index.
+ */
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out);
+
+/** \brief Initialize a standalone true peak meter.
+ *
+ *  This is the oversampling meter used by FF_EBUR128_MODE_TRUE_PEAK, for
+ *  callers which do their own loudness measurement.
+ *
+ *  @param channels the number of channels.
+ *  @param samplerate the sample rate, which selects the oversampling factor.
+ *  @return an initialized true peak meter, NULL on allocation failure.
+ */
+FFEBUR128TruePeak *ff_ebur128_true_peak_init(unsigned int channels,
+                                             unsigned long samplerate);
+
+/** \brief Destroy a true peak meter.
+ *
+ *  @param tp pointer to a true peak meter, set to NULL.
+ */
+void ff_ebur128_true_peak_destroy(FFEBUR128TruePeak **tp);
+
+/** \brief Feed samples of one channel to the true peak meter.
+ *
+ *  Channels are independent, so different channels may be fed concurrently.
+ *  The interpolated samples lag the input by 6 samples.
+ *
+ *  @param tp true peak meter.
+ *  @param channel channel the samples belong to.
+ *  @param src first sample.
+ *  @param frames number of samples.
+ *  @param stride distance between two samples, in samples.
+ *  @return maximum absolute value of the oversampled signal for this call.
+ */
+double ff_ebur128_true_peak_add_frames(FFEBUR128TruePeak *tp, unsigned int channel,
+                                       const double *src, size_t frames, int stride);
+
 /** \brief Get relative threshold in LUFS.
  *
  *  @param st library state
@@ -391,6 +391,14 @@ static inline int ff_norm_qscale(int qscale, int type)
  */
 int ff_filter_get_nb_threads(AVFilterContext *ctx);
 
+/**
+ * Check if the jobs started by ctx->internal->execute() are all run at the
+ * same time, so that they may wait for each other. This is only the case
+ * for the slice thread pool of libavfilter itself, and only when no more
+ * jobs than ff_filter_get_nb_threads() are started.
+ */
+int ff_filter_execute_is_concurrent(AVFilterContext *ctx);
+
 /**
  * Generic processing of user supplied commands that are set
  * in the same way as the filter options.
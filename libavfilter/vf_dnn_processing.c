@@ -53,6 +53,11 @@ typedef struct DnnProcessingContext {
     struct SwsContext *sws_grayf32_to_gray8;
     struct SwsContext *sws_uv_scale;
     int sws_uv_height;
+
+    int batch_size;
+    // input frames whose data is already in the model input, in order
+    AVFrame **pending;
+    int nb_pending;
 } DnnProcessingContext;
 
 #define OFFSET(x) offsetof(DnnProcessingContext, x)
@@ -66,6 +71,7 @@ static const AVOption dnn_processing_options[] = {
     { "model",       "path to model file",         OFFSET(model_filename),   AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
     { "input",       "input name of the model",    OFFSET(model_inputname),  AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
     { "output",      "output name of the model",   OFFSET(model_outputname), AV_OPT_TYPE_STRING,    { .str = NULL }, 0, 0, FLAGS },
+    { "batch_size",  "frames per model execution", OFFSET(batch_size),       AV_OPT_TYPE_INT,       { .i64 = 1 },    1, 64, FLAGS },
     { NULL }
 };
 
@@ -98,12 +104,17 @@ static av_cold int init(AVFilterContext *context)
         return AVERROR(EINVAL);
     }
 
-    ctx->model = (ctx->dnn_module->load_model)(ctx->model_filename);
+    ctx->model = (ctx->dnn_module->load_model)(ctx->model_filename,
+                                               ff_filter_get_nb_threads(context));
     if (!ctx->model) {
         av_log(ctx, AV_LOG_ERROR, "could not load DNN model\n");
         return AVERROR(EINVAL);
     }
 
+    ctx->pending = av_calloc(ctx->batch_size, sizeof(*ctx->pending));
+    if (!ctx->pending)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -212,6 +223,7 @@ static int config_input(AVFilterLink *inlink)
     ctx->input.height   = inlink->h;
     ctx->input.channels = model_input.channels;
     ctx->input.dt = model_input.dt;
+    ctx->input.batch_size = ctx->batch_size;
 
     result = (ctx->model->set_input_output)(ctx->model->model,
                                         &ctx->input, ctx->model_inputname,
@@ -318,10 +330,24 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
-static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *frame)
+static size_t dnn_frame_size(const DNNData *data)
+{
+    return (size_t)data->width * data->height * data->channels *
+           (data->dt == DNN_FLOAT ? sizeof(float) : sizeof(uint8_t));
+}
+
+// the part of a batched model input/output that holds the idx-th frame
+static DNNData dnn_batch_slot(const DNNData *data, int idx)
+{
+    DNNData slot = *data;
+    slot.data = (uint8_t *)data->data + idx * dnn_frame_size(data);
+    slot.batch_size = 1;
+    return slot;
+}
+
+static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const DNNData *dnn_input, const AVFrame *frame)
 {
     int bytewidth = av_image_get_linesize(frame->format, frame->width, 0);
-    DNNData *dnn_input = &ctx->input;
 
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
@@ -329,7 +355,7 @@ static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *fram
         if (dnn_input->dt == DNN_FLOAT) {
             sws_scale(ctx->sws_gray8_to_grayf32, (const uint8_t **)frame->data, frame->linesize,
                       0, frame->height, (uint8_t * const*)(&dnn_input->data),
-                      (const int [4]){frame->linesize[0] * sizeof(float), 0, 0, 0});
+                      (const int [4]){bytewidth * sizeof(float), 0, 0, 0});
         } else {
             av_assert0(dnn_input->dt == DNN_UINT8);
             av_image_copy_plane(dnn_input->data, bytewidth,
@@ -359,17 +385,16 @@ static int copy_from_frame_to_dnn(DnnProcessingContext *ctx, const AVFrame *fram
     return 0;
 }
 
-static int copy_from_dnn_to_frame(DnnProcessingContext *ctx, AVFrame *frame)
+static int copy_from_dnn_to_frame(DnnProcessingContext *ctx, const DNNData *dnn_output, AVFrame *frame)
 {
     int bytewidth = av_image_get_linesize(frame->format, frame->width, 0);
-    DNNData *dnn_output = &ctx->output;
 
     switch (frame->format) {
     case AV_PIX_FMT_RGB24:
     case AV_PIX_FMT_BGR24:
         if (dnn_output->dt == DNN_FLOAT) {
             sws_scale(ctx->sws_grayf32_to_gray8, (const uint8_t *[4]){(const uint8_t *)dnn_output->data, 0, 0, 0},
-                      (const int[4]){frame->linesize[0] * sizeof(float), 0, 0, 0},
+                      (const int[4]){bytewidth * sizeof(float), 0, 0, 0},
                       0, frame->height, (uint8_t * const*)frame->data, frame->linesize);
 
         } else {
@@ -441,37 +466,75 @@ static int copy_uv_planes(DnnProcessingContext *ctx, AVFrame *out, const AVFrame
     return 0;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+static int flush_pending(AVFilterContext *context)
 {
-    AVFilterContext *context  = inlink->dst;
     AVFilterLink *outlink = context->outputs[0];
     DnnProcessingContext *ctx = context->priv;
+    int nb_pending = ctx->nb_pending;
     DNNReturnType dnn_result;
-    AVFrame *out;
-
-    copy_from_frame_to_dnn(ctx, in);
+    int ret = 0;
 
+    ctx->nb_pending = 0;
     dnn_result = (ctx->dnn_module->execute_model)(ctx->model, &ctx->output, 1);
     if (dnn_result != DNN_SUCCESS){
         av_log(ctx, AV_LOG_ERROR, "failed to execute model\n");
-        av_frame_free(&in);
-        return AVERROR(EIO);
+        ret = AVERROR(EIO);
     }
 
-    out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    if (!out) {
+    for (int i = 0; i < nb_pending; i++) {
+        AVFrame *in = ctx->pending[i];
+        AVFrame *out = NULL;
+        DNNData output = dnn_batch_slot(&ctx->output, i);
+
+        ctx->pending[i] = NULL;
+        if (ret >= 0) {
+            out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
+            if (!out)
+                ret = AVERROR(ENOMEM);
+        }
+        if (ret < 0) {
+            av_frame_free(&in);
+            continue;
+        }
+
+        av_frame_copy_props(out, in);
+        copy_from_dnn_to_frame(ctx, &output, out);
+
+        if (isPlanarYUV(in->format))
+            copy_uv_planes(ctx, out, in);
+
         av_frame_free(&in);
-        return AVERROR(ENOMEM);
+        ret = ff_filter_frame(outlink, out);
     }
 
-    av_frame_copy_props(out, in);
-    copy_from_dnn_to_frame(ctx, out);
+    return ret;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *context  = inlink->dst;
+    DnnProcessingContext *ctx = context->priv;
+    DNNData input = dnn_batch_slot(&ctx->input, ctx->nb_pending);
+
+    copy_from_frame_to_dnn(ctx, &input, in);
 
-    if (isPlanarYUV(in->format))
-        copy_uv_planes(ctx, out, in);
+    ctx->pending[ctx->nb_pending++] = in;
+    if (ctx->nb_pending < ctx->batch_size)
+        return 0;
 
-    av_frame_free(&in);
-    return ff_filter_frame(outlink, out);
+    return flush_pending(context);
+}
+
+static int request_frame(AVFilterLink *outlink)
+{
+    AVFilterContext *context  = outlink->src;
+    DnnProcessingContext *ctx = context->priv;
+    int ret = ff_request_frame(context->inputs[0]);
+
+    if (ret == AVERROR_EOF && ctx->nb_pending)
+        ret = flush_pending(context);
+
+    return ret;
 }
 
 static av_cold void uninit(AVFilterContext *ctx)
@@ -482,6 +545,12 @@ static av_cold void uninit(AVFilterContext *ctx)
     sws_freeContext(context->sws_grayf32_to_gray8);
     sws_freeContext(context->sws_uv_scale);
 
+    if (context->pending) {
+        for (int i = 0; i < context->nb_pending; i++)
+            av_frame_free(&context->pending[i]);
+        av_freep(&context->pending);
+    }
+
     if (context->dnn_module)
         (context->dnn_module->free_model)(&context->model);
 
@@ -500,9 +569,10 @@ static const AVFilterPad dnn_processing_inputs[] = {
 
 static const AVFilterPad dnn_processing_outputs[] = {
     {
-        .name = "default",
-        .type = AVMEDIA_TYPE_VIDEO,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
         .config_props  = config_output,
+        .request_frame = request_frame,
     },
     { NULL }
 };
@@ -203,6 +203,14 @@ typedef struct DrawTextContext {
     int text_shaping;               ///< 1 to shape the text before drawing it
 #endif
     AVDictionary *metadata;
+
+    char *cache_text;               ///< expanded text the layout and raster below belong to
+    unsigned int cache_fontsize;    ///< font size the layout and raster below belong to
+    int text_w, text_h;             ///< size of the laid out text
+    uint8_t *raster;                ///< 8-bit coverage of all glyphs, followed by the border coverage
+    unsigned int raster_size;       ///< allocated size of raster
+    int raster_x, raster_y;         ///< position of the raster relative to the text origin
+    int raster_w, raster_h;         ///< size of the raster
 } DrawTextContext;
 
 #define OFFSET(x) offsetof(DrawTextContext, x)
@@ -813,6 +821,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->positions);
     s->nb_positions = 0;
 
+    av_freep(&s->cache_text);
+    av_freep(&s->raster);
+    s->raster_size = 0;
+
     av_tree_enumerate(s->glyphs, NULL, NULL, glyph_enu_free);
     av_tree_destroy(s->glyphs);
     s->glyphs = NULL;
@@ -1211,19 +1223,36 @@ static int expand_text(AVFilterContext *ctx, char *text, AVBPrint *bp)
     return 0;
 }
 
-static int draw_glyphs(DrawTextContext *s, AVFrame *frame,
-                       int width, int height,
-                       FFDrawColor *color,
-                       int x, int y, int borderw)
+static void composite_bitmap(uint8_t *dst, int dst_linesize, const FT_Bitmap *bitmap)
+{
+    for (int y = 0; y < bitmap->rows; y++) {
+        const uint8_t *src = bitmap->buffer + y * bitmap->pitch;
+        for (int x = 0; x < bitmap->width; x++) {
+            unsigned m = bitmap->pixel_mode == FT_PIXEL_MODE_MONO ?
+                         (src[x >> 3] >> (7 - (x & 7)) & 1) * 255 : src[x];
+            /* same coverage as blending both glyphs one after the other
+             * with an opaque color */
+            dst[x] += ((255 - dst[x]) * m + 127) / 255;
+        }
+        dst += dst_linesize;
+    }
+}
+
+/**
+ * Render the laid out text into one coverage raster (plus one for the
+ * border), so that it can be blended in a single pass per color.
+ */
+static int render_text(DrawTextContext *s)
 {
     char *text = s->expanded_text.str;
     uint32_t code = 0;
-    int i, x1, y1;
+    int i, x0 = INT_MAX, y0 = INT_MAX, x1 = INT_MIN, y1 = INT_MIN;
+    int borderw = s->borderw;
     uint8_t *p;
     Glyph *glyph = NULL;
+    size_t size;
 
     for (i = 0, p = text; *p; i++) {
-        FT_Bitmap bitmap;
         Glyph dummy = { 0 };
         GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
 continue_on_invalid:
@@ -1236,26 +1265,159 @@ continue_on_invalid:
         dummy.fontsize = s->fontsize;
         glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
 
-        bitmap = borderw ? glyph->border_bitmap : glyph->bitmap;
-
         if (glyph->bitmap.pixel_mode != FT_PIXEL_MODE_MONO &&
             glyph->bitmap.pixel_mode != FT_PIXEL_MODE_GRAY)
             return AVERROR(EINVAL);
 
-        x1 = s->positions[i].x+s->x+x - borderw;
-        y1 = s->positions[i].y+s->y+y - borderw;
+        x0 = FFMIN(x0, s->positions[i].x - borderw);
+        y0 = FFMIN(y0, s->positions[i].y - borderw);
+        x1 = FFMAX(x1, s->positions[i].x + (int)glyph->bitmap.width);
+        y1 = FFMAX(y1, s->positions[i].y + (int)glyph->bitmap.rows);
+        if (borderw) {
+            x1 = FFMAX(x1, s->positions[i].x - borderw + (int)glyph->border_bitmap.width);
+            y1 = FFMAX(y1, s->positions[i].y - borderw + (int)glyph->border_bitmap.rows);
+        }
+    }
 
-        ff_blend_mask(&s->dc, color,
-                      frame->data, frame->linesize, width, height,
-                      bitmap.buffer, bitmap.pitch,
-                      bitmap.width, bitmap.rows,
-                      bitmap.pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
-                      0, x1, y1);
+    s->raster_w = s->raster_h = 0;
+    if (x0 >= x1 || y0 >= y1)
+        return 0;
+
+    s->raster_x = x0;
+    s->raster_y = y0;
+    s->raster_w = x1 - x0;
+    s->raster_h = y1 - y0;
+    size = (size_t)s->raster_w * s->raster_h * (borderw ? 2 : 1);
+    av_fast_malloc(&s->raster, &s->raster_size, size);
+    if (!s->raster)
+        return AVERROR(ENOMEM);
+    memset(s->raster, 0, size);
+
+    for (i = 0, p = text; *p; i++) {
+        Glyph dummy = { 0 };
+        uint8_t *dst;
+        GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid2;);
+continue_on_invalid2:
+
+        if (code == '\n' || code == '\r' || code == '\t')
+            continue;
+
+        dummy.code = code;
+        dummy.fontsize = s->fontsize;
+        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+
+        dst = s->raster + (s->positions[i].y - y0) * s->raster_w + s->positions[i].x - x0;
+        composite_bitmap(dst, s->raster_w, &glyph->bitmap);
+        if (borderw) {
+            dst = s->raster + s->raster_w * s->raster_h +
+                  (s->positions[i].y - borderw - y0) * s->raster_w +
+                  s->positions[i].x - borderw - x0;
+            composite_bitmap(dst, s->raster_w, &glyph->border_bitmap);
+        }
     }
 
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    FFDrawColor *color;
+    const uint8_t *mask;
+    int x, y;
+} ThreadData;
+
+static int slice_boundary(const DrawTextContext *s, const ThreadData *td,
+                          int jobnr, int nb_jobs)
+{
+    int y;
+
+    if (jobnr == 0)
+        return td->y;
+    if (jobnr == nb_jobs)
+        return td->y + s->raster_h;
+    /* keep subsampled chroma rows inside a single slice */
+    y = td->y + s->raster_h * jobnr / nb_jobs;
+    y = (y >> s->dc.vsub_max) << s->dc.vsub_max;
+    return FFMAX(y, td->y);
+}
+
+static int blend_raster_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    int start = slice_boundary(s, td, jobnr,     nb_jobs);
+    int end   = slice_boundary(s, td, jobnr + 1, nb_jobs);
+
+    if (end > start)
+        ff_blend_mask(&s->dc, td->color,
+                      frame->data, frame->linesize, frame->width, frame->height,
+                      td->mask + (start - td->y) * s->raster_w, s->raster_w,
+                      s->raster_w, end - start, 3, 0, td->x, start);
+    return 0;
+}
+
+/**
+ * Blend the glyphs one after the other. Translucent colors need this,
+ * as blending the combined coverage of overlapping glyphs once is not
+ * the same as blending each of them.
+ */
+static void blend_glyphs(DrawTextContext *s, AVFrame *frame,
+                         FFDrawColor *color, int x, int y, int borderw)
+{
+    char *text = s->expanded_text.str;
+    uint32_t code = 0;
+    int i;
+    uint8_t *p;
+    Glyph *glyph = NULL;
+
+    for (i = 0, p = text; *p; i++) {
+        const FT_Bitmap *bitmap;
+        Glyph dummy = { 0 };
+        GET_UTF8(code, *p ? *p++ : 0, code = 0xfffd; goto continue_on_invalid;);
+continue_on_invalid:
+
+        if (code == '\n' || code == '\r' || code == '\t')
+            continue;
+
+        dummy.code = code;
+        dummy.fontsize = s->fontsize;
+        glyph = av_tree_find(s->glyphs, &dummy, glyph_cmp, NULL);
+
+        bitmap = borderw ? &glyph->border_bitmap : &glyph->bitmap;
+        ff_blend_mask(&s->dc, color,
+                      frame->data, frame->linesize, frame->width, frame->height,
+                      bitmap->buffer, bitmap->pitch,
+                      bitmap->width, bitmap->rows,
+                      bitmap->pixel_mode == FT_PIXEL_MODE_MONO ? 0 : 3,
+                      0, s->positions[i].x + s->x + x - borderw,
+                      s->positions[i].y + s->y + y - borderw);
+    }
+}
+
+static void blend_raster(AVFilterContext *ctx, AVFrame *frame,
+                         FFDrawColor *color, int x, int y, int border)
+{
+    DrawTextContext *s = ctx->priv;
+    ThreadData td;
+    int nb_jobs;
+
+    if (!s->raster_w || !s->raster_h || !color->rgba[3])
+        return;
+
+    if (color->rgba[3] < 255) {
+        blend_glyphs(s, frame, color, x, y, border ? s->borderw : 0);
+        return;
+    }
+
+    td.frame = frame;
+    td.color = color;
+    td.mask  = s->raster + (border ? s->raster_w * s->raster_h : 0);
+    td.x     = s->x + s->raster_x + x;
+    td.y     = s->y + s->raster_y + y;
+    nb_jobs  = av_clip(s->raster_h >> s->dc.vsub_max, 1, ff_filter_get_nb_threads(ctx));
+    ctx->internal->execute(ctx, blend_raster_slice, &td, NULL, nb_jobs);
+}
 
 static void update_color_with_alpha(DrawTextContext *s, FFDrawColor *color, const FFDrawColor incolor)
 {
@@ -1279,17 +1441,18 @@ static void update_alpha(DrawTextContext *s)
         s->alpha = 256 * alpha;
 }
 
-static int draw_text(AVFilterContext *ctx, AVFrame *frame,
-                     int width, int height)
+/**
+ * Load the glyphs of the expanded text, compute their positions and
+ * render them, unless the text and font size are the same as for the
+ * previous frame.
+ */
+static int layout_text(AVFilterContext *ctx)
 {
     DrawTextContext *s = ctx->priv;
-    AVFilterLink *inlink = ctx->inputs[0];
-
     uint32_t code = 0, prev_code = 0;
     int x = 0, y = 0, i = 0, ret;
-    int max_text_line_w = 0, len;
-    int box_w, box_h;
-    char *text;
+    int max_text_line_w = 0;
+    char *text = s->expanded_text.str;
     uint8_t *p;
     int y_min = 32000, y_max = -32000;
     int x_min = 32000, x_max = -32000;
@@ -1297,70 +1460,7 @@ static int draw_text(AVFilterContext *ctx, AVFrame *frame,
     Glyph *glyph = NULL, *prev_glyph = NULL;
     Glyph dummy = { 0 };
 
-    time_t now = time(0);
-    struct tm ltime;
-    AVBPrint *bp = &s->expanded_text;
-
-    FFDrawColor fontcolor;
-    FFDrawColor shadowcolor;
-    FFDrawColor bordercolor;
-    FFDrawColor boxcolor;
-
-    av_bprint_clear(bp);
-
-    if(s->basetime != AV_NOPTS_VALUE)
-        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
-
-    switch (s->exp_mode) {
-    case EXP_NONE:
-        av_bprintf(bp, "%s", s->text);
-        break;
-    case EXP_NORMAL:
-        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
-            return ret;
-        break;
-    case EXP_STRFTIME:
-        localtime_r(&now, &ltime);
-        av_bprint_strftime(bp, s->text, &ltime);
-        break;
-    }
-
-    if (s->tc_opt_string) {
-        char tcbuf[AV_TIMECODE_STR_SIZE];
-        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
-        av_bprint_clear(bp);
-        av_bprintf(bp, "%s%s", s->text, tcbuf);
-    }
-
-    if (!av_bprint_is_complete(bp))
-        return AVERROR(ENOMEM);
-    text = s->expanded_text.str;
-    if ((len = s->expanded_text.len) > s->nb_positions) {
-        if (!(s->positions =
-              av_realloc(s->positions, len*sizeof(*s->positions))))
-            return AVERROR(ENOMEM);
-        s->nb_positions = len;
-    }
-
-    if (s->fontcolor_expr[0]) {
-        /* If expression is set, evaluate and replace the static value */
-        av_bprint_clear(&s->expanded_fontcolor);
-        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
-            return ret;
-        if (!av_bprint_is_complete(&s->expanded_fontcolor))
-            return AVERROR(ENOMEM);
-        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
-        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
-        if (ret)
-            return ret;
-        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
-    }
-
-    x = 0;
-    y = 0;
-
-    if ((ret = update_fontsize(ctx)) < 0)
-        return ret;
+    av_freep(&s->cache_text);
 
     /* load and cache glyphs */
     for (i = 0, p = text; *p; i++) {
@@ -1436,6 +1536,98 @@ continue_on_invalid2:
 
     s->var_values[VAR_LINE_H] = s->var_values[VAR_LH] = s->max_glyph_h;
 
+    s->text_w = max_text_line_w;
+    s->text_h = y + s->max_glyph_h;
+
+    if ((ret = render_text(s)) < 0)
+        return ret;
+
+    s->cache_text = av_strdup(text);
+    if (!s->cache_text)
+        return AVERROR(ENOMEM);
+    s->cache_fontsize = s->fontsize;
+
+    return 0;
+}
+
+static int draw_text(AVFilterContext *ctx, AVFrame *frame,
+                     int width, int height)
+{
+    DrawTextContext *s = ctx->priv;
+    AVFilterLink *inlink = ctx->inputs[0];
+
+    int ret, len;
+    int box_w, box_h;
+    char *text;
+
+    time_t now = time(0);
+    struct tm ltime;
+    AVBPrint *bp = &s->expanded_text;
+
+    FFDrawColor fontcolor;
+    FFDrawColor shadowcolor;
+    FFDrawColor bordercolor;
+    FFDrawColor boxcolor;
+
+    av_bprint_clear(bp);
+
+    if(s->basetime != AV_NOPTS_VALUE)
+        now= frame->pts*av_q2d(ctx->inputs[0]->time_base) + s->basetime/1000000;
+
+    switch (s->exp_mode) {
+    case EXP_NONE:
+        av_bprintf(bp, "%s", s->text);
+        break;
+    case EXP_NORMAL:
+        if ((ret = expand_text(ctx, s->text, &s->expanded_text)) < 0)
+            return ret;
+        break;
+    case EXP_STRFTIME:
+        localtime_r(&now, &ltime);
+        av_bprint_strftime(bp, s->text, &ltime);
+        break;
+    }
+
+    if (s->tc_opt_string) {
+        char tcbuf[AV_TIMECODE_STR_SIZE];
+        av_timecode_make_string(&s->tc, tcbuf, inlink->frame_count_out);
+        av_bprint_clear(bp);
+        av_bprintf(bp, "%s%s", s->text, tcbuf);
+    }
+
+    if (!av_bprint_is_complete(bp))
+        return AVERROR(ENOMEM);
+    text = s->expanded_text.str;
+    if ((len = s->expanded_text.len) > s->nb_positions) {
+        if (!(s->positions =
+              av_realloc(s->positions, len*sizeof(*s->positions))))
+            return AVERROR(ENOMEM);
+        s->nb_positions = len;
+    }
+
+    if (s->fontcolor_expr[0]) {
+        /* If expression is set, evaluate and replace the static value */
+        av_bprint_clear(&s->expanded_fontcolor);
+        if ((ret = expand_text(ctx, s->fontcolor_expr, &s->expanded_fontcolor)) < 0)
+            return ret;
+        if (!av_bprint_is_complete(&s->expanded_fontcolor))
+            return AVERROR(ENOMEM);
+        av_log(s, AV_LOG_DEBUG, "Evaluated fontcolor is '%s'\n", s->expanded_fontcolor.str);
+        ret = av_parse_color(s->fontcolor.rgba, s->expanded_fontcolor.str, -1, s);
+        if (ret)
+            return ret;
+        ff_draw_color(&s->dc, &s->fontcolor, s->fontcolor.rgba);
+    }
+
+    if ((ret = update_fontsize(ctx)) < 0)
+        return ret;
+
+    if (!s->cache_text || s->cache_fontsize != s->fontsize ||
+        strcmp(s->cache_text, text)) {
+        if ((ret = layout_text(ctx)) < 0)
+            return ret;
+    }
+
     s->x = s->var_values[VAR_X] = av_expr_eval(s->x_pexpr, s->var_values, &s->prng);
     s->y = s->var_values[VAR_Y] = av_expr_eval(s->y_pexpr, s->var_values, &s->prng);
     /* It is necessary if x is expressed from y  */
@@ -1447,8 +1639,8 @@ continue_on_invalid2:
     update_color_with_alpha(s, &bordercolor, s->bordercolor);
     update_color_with_alpha(s, &boxcolor   , s->boxcolor   );
 
-    box_w = max_text_line_w;
-    box_h = y + s->max_glyph_h;
+    box_w = s->text_w;
+    box_h = s->text_h;
 
     if (s->fix_bounds) {
 
@@ -1483,20 +1675,13 @@ continue_on_invalid2:
                            s->x - s->boxborderw, s->y - s->boxborderw,
                            box_w + s->boxborderw * 2, box_h + s->boxborderw * 2);
 
-    if (s->shadowx || s->shadowy) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &shadowcolor, s->shadowx, s->shadowy, 0)) < 0)
-            return ret;
-    }
+    if (s->shadowx || s->shadowy)
+        blend_raster(ctx, frame, &shadowcolor, s->shadowx, s->shadowy, 0);
 
-    if (s->borderw) {
-        if ((ret = draw_glyphs(s, frame, width, height,
-                               &bordercolor, 0, 0, s->borderw)) < 0)
-            return ret;
-    }
-    if ((ret = draw_glyphs(s, frame, width, height,
-                           &fontcolor, 0, 0, 0)) < 0)
-        return ret;
+    if (s->borderw)
+        blend_raster(ctx, frame, &bordercolor, 0, 0, 1);
+
+    blend_raster(ctx, frame, &fontcolor, 0, 0, 0);
 
     return 0;
 }
@@ -1572,5 +1757,5 @@ AVFilter ff_vf_drawtext = {
     .inputs        = avfilter_vf_drawtext_inputs,
     .outputs       = avfilter_vf_drawtext_outputs,
     .process_command = command,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
 };
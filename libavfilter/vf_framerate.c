@@ -62,6 +62,25 @@ static const AVOption framerate_options[] = {
 
 AVFILTER_DEFINE_CLASS(framerate);
 
+typedef struct SceneThreadData {
+    AVFrame *crnt, *next;
+} SceneThreadData;
+
+static int scene_sad_slice(AVFilterContext *ctx, void *arg, int job, int nb_jobs)
+{
+    FrameRateContext *s = ctx->priv;
+    SceneThreadData *td = arg;
+    AVFrame *crnt = td->crnt;
+    AVFrame *next = td->next;
+    const int start = (crnt->height *  job   ) / nb_jobs;
+    const int end   = (crnt->height * (job+1)) / nb_jobs;
+
+    s->sad(crnt->data[0] + start * crnt->linesize[0], crnt->linesize[0],
+           next->data[0] + start * next->linesize[0], next->linesize[0],
+           crnt->width, end - start, &s->sad_sums[job]);
+    return 0;
+}
+
 static double get_scene_score(AVFilterContext *ctx, AVFrame *crnt, AVFrame *next)
 {
     FrameRateContext *s = ctx->priv;
@@ -71,12 +90,18 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *crnt, AVFrame *next
 
     if (crnt->height == next->height &&
         crnt->width  == next->width) {
-        uint64_t sad;
+        SceneThreadData td;
+        uint64_t sad = 0;
         double mafd, diff;
+        int i, nb_jobs = FFMIN(FFMAX(1, crnt->height >> 4), s->nb_sad_sums);
 
         ff_dlog(ctx, "get_scene_score() process\n");
-        s->sad(crnt->data[0], crnt->linesize[0], next->data[0], next->linesize[0], crnt->width, crnt->height, &sad);
+        td.crnt = crnt;
+        td.next = next;
+        ctx->internal->execute(ctx, scene_sad_slice, &td, NULL, nb_jobs);
         emms_c();
+        for (i = 0; i < nb_jobs; i++)
+            sad += s->sad_sums[i];
         mafd = (double)sad * 100.0 / (crnt->width * crnt->height) / (1 << s->bitdepth);
         diff = fabs(mafd - s->prev_mafd);
         ret  = av_clipf(FFMIN(mafd, diff), 0, 100.0);
@@ -212,6 +237,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     FrameRateContext *s = ctx->priv;
     av_frame_free(&s->f0);
     av_frame_free(&s->f1);
+    av_freep(&s->sad_sums);
 }
 
 static int query_formats(AVFilterContext *ctx)
@@ -292,6 +318,12 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_sad_sums = ff_filter_get_nb_threads(ctx);
+    av_freep(&s->sad_sums);
+    s->sad_sums = av_calloc(s->nb_sad_sums, sizeof(*s->sad_sums));
+    if (!s->sad_sums)
+        return AVERROR(ENOMEM);
+
     s->srce_time_base = inlink->time_base;
 
     ff_framerate_init(s);
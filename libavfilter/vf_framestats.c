@@ -0,0 +1,423 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Combined per-frame analysis: luma statistics, black pixel ratio,
+ * difference against the previous frame and scene score computed in one
+ * slice threaded pass over the luma plane, plus the crop bounds, all
+ * exported as frame metadata.
+ */
+
+#include <float.h>
+
+#include "libavutil/imgutils.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+
+#include "avfilter.h"
+#include "formats.h"
+#include "internal.h"
+#include "scene_sad.h"
+#include "video.h"
+
+typedef struct SliceStats {
+    uint64_t sum;               ///< sum of the analysed luma samples
+    uint64_t black;             ///< number of luma samples at or below the black threshold
+    uint64_t sad;               ///< luma sum of absolute differences against the previous frame
+    int min, max;
+} SliceStats;
+
+typedef struct FrameStatsContext {
+    const AVClass *class;
+
+    double pixel_black_th;
+    float limit;
+    int step;
+
+    int depth;
+    int width;                  ///< luma width, in samples
+    int rows;                   ///< number of analysed luma rows
+    int black_th_i;
+    int limit_i;
+
+    ff_scene_sad_fn sad;
+    AVFrame *prev_picref;
+    double prev_mafd;
+
+    int nb_jobs;
+    SliceStats *slices;
+    uint32_t (*histograms)[4][256]; ///< per job luma histograms for 8-bit input
+} FrameStatsContext;
+
+typedef struct ThreadData {
+    AVFrame *in, *prev;
+} ThreadData;
+
+#define OFFSET(x) offsetof(FrameStatsContext, x)
+#define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
+
+static const AVOption framestats_options[] = {
+    { "pixel_black_th", "set the pixel black threshold",                   OFFSET(pixel_black_th), AV_OPT_TYPE_DOUBLE, {.dbl=.10},      0, 1,     FLAGS },
+    { "pix_th",         "set the pixel black threshold",                   OFFSET(pixel_black_th), AV_OPT_TYPE_DOUBLE, {.dbl=.10},      0, 1,     FLAGS },
+    { "limit",          "set the threshold below which a line is black",   OFFSET(limit),          AV_OPT_TYPE_FLOAT,  {.dbl=24.0/255}, 0, 65535, FLAGS },
+    { "step",           "analyse only every step-th line",                 OFFSET(step),           AV_OPT_TYPE_INT,    {.i64=1},        1, 64,    FLAGS },
+    { NULL }
+};
+
+AVFILTER_DEFINE_CLASS(framestats);
+
+#define YUVJ_FORMATS \
+    AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P, AV_PIX_FMT_YUVJ444P, AV_PIX_FMT_YUVJ440P
+
+static const enum AVPixelFormat yuvj_formats[] = {
+    YUVJ_FORMATS, AV_PIX_FMT_NONE
+};
+
+static int query_formats(AVFilterContext *ctx)
+{
+    static const enum AVPixelFormat pix_fmts[] = {
+        AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY9, AV_PIX_FMT_GRAY10,
+        AV_PIX_FMT_GRAY12, AV_PIX_FMT_GRAY14, AV_PIX_FMT_GRAY16,
+        AV_PIX_FMT_YUV410P, AV_PIX_FMT_YUV411P,
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
+        AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV444P,
+        YUVJ_FORMATS,
+        AV_PIX_FMT_YUV420P9,  AV_PIX_FMT_YUV422P9,  AV_PIX_FMT_YUV444P9,
+        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV422P10, AV_PIX_FMT_YUV444P10,
+        AV_PIX_FMT_YUV420P12, AV_PIX_FMT_YUV422P12, AV_PIX_FMT_YUV444P12,
+        AV_PIX_FMT_YUV420P14, AV_PIX_FMT_YUV422P14, AV_PIX_FMT_YUV444P14,
+        AV_PIX_FMT_YUV420P16, AV_PIX_FMT_YUV422P16, AV_PIX_FMT_YUV444P16,
+        AV_PIX_FMT_NONE
+    };
+
+    AVFilterFormats *fmts_list = ff_make_format_list(pix_fmts);
+    if (!fmts_list)
+        return AVERROR(ENOMEM);
+    return ff_set_common_formats(ctx, fmts_list);
+}
+
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    FrameStatsContext *s = ctx->priv;
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    int shift;
+
+    s->depth = desc->comp[0].depth;
+    s->width = inlink->w;
+    s->rows  = (inlink->h + s->step - 1) / s->step;
+    shift    = s->depth - 8;
+
+    /* same thresholds as blackdetect and cropdetect */
+    s->black_th_i = ff_fmt_is_in(inlink->format, yuvj_formats) ?
+                         s->pixel_black_th *  255 :
+                    16 + s->pixel_black_th * (235 - 16);
+    s->black_th_i <<= shift;
+    s->limit_i = lrint(s->limit < 1.0 ? s->limit * ((1 << s->depth) - 1) : s->limit);
+
+    s->sad = ff_scene_sad_get_fn(s->depth == 8 ? 8 : 16);
+    if (!s->sad)
+        return AVERROR(EINVAL);
+
+    s->nb_jobs = FFMAX(1, FFMIN(s->rows, ff_filter_get_nb_threads(ctx)));
+
+    av_freep(&s->slices);
+    av_freep(&s->histograms);
+    s->slices     = av_calloc(s->nb_jobs, sizeof(*s->slices));
+    s->histograms = av_calloc(s->nb_jobs, sizeof(*s->histograms));
+    if (!s->slices || !s->histograms)
+        return AVERROR(ENOMEM);
+
+    av_frame_free(&s->prev_picref);
+    s->prev_mafd = 0;
+
+    return 0;
+}
+
+/* compare a line against the previous frame while it is still cached */
+static av_always_inline uint64_t line_sad(FrameStatsContext *s, const AVFrame *prev,
+                                          const uint8_t *src, ptrdiff_t linesize, int y)
+{
+    const ptrdiff_t prev_linesize = prev->linesize[0] * s->step;
+    uint64_t sad;
+
+    s->sad(prev->data[0] + y * prev_linesize, prev_linesize,
+           src, linesize, s->width, 1, &sad);
+    return sad;
+}
+
+static void luma_stats8(FrameStatsContext *s, SliceStats *ss, const ThreadData *td,
+                        uint32_t hist[4][256], int start, int end)
+{
+    const ptrdiff_t linesize = td->in->linesize[0] * s->step;
+    const int width = s->width;
+    uint64_t sad = 0;
+    int min = 255, max = 0;
+
+    memset(hist, 0, 4 * sizeof(*hist));
+
+    for (int y = start; y < end; y++) {
+        const uint8_t *src = td->in->data[0] + y * linesize;
+        int x;
+
+        /* interleave several histograms to avoid stalls on flat areas */
+        for (x = 0; x < width - 3; x += 4) {
+            hist[0][src[x    ]]++;
+            hist[1][src[x + 1]]++;
+            hist[2][src[x + 2]]++;
+            hist[3][src[x + 3]]++;
+        }
+        for (; x < width; x++)
+            hist[0][src[x]]++;
+
+        if (td->prev)
+            sad += line_sad(s, td->prev, src, linesize, y);
+    }
+
+    ss->sum = ss->black = 0;
+    for (int v = 0; v < 256; v++) {
+        unsigned n = hist[0][v] + hist[1][v] + hist[2][v] + hist[3][v];
+
+        if (n) {
+            min = FFMIN(min, v);
+            max = v;
+        }
+        ss->sum += (uint64_t)n * v;
+        if (v <= s->black_th_i)
+            ss->black += n;
+    }
+    ss->sad = sad;
+    ss->min = min;
+    ss->max = max;
+}
+
+static void luma_stats16(FrameStatsContext *s, SliceStats *ss, const ThreadData *td,
+                         int start, int end)
+{
+    const ptrdiff_t linesize = td->in->linesize[0] * s->step;
+    const int width = s->width;
+    const int black_th = s->black_th_i;
+    int min = INT_MAX, max = 0;
+    uint64_t sum = 0, black = 0, sad = 0;
+
+    for (int y = start; y < end; y++) {
+        const uint8_t *src = td->in->data[0] + y * linesize;
+        const uint16_t *src16 = (const uint16_t *)src;
+        unsigned nb_black = 0;
+
+        for (int x = 0; x < width; x++) {
+            int v = src16[x];
+
+            sum      += v;
+            nb_black += v <= black_th;
+            min = FFMIN(min, v);
+            max = FFMAX(max, v);
+        }
+        black += nb_black;
+
+        if (td->prev)
+            sad += line_sad(s, td->prev, src, linesize, y);
+    }
+
+    ss->sum   = sum;
+    ss->black = black;
+    ss->sad   = sad;
+    ss->min   = min;
+    ss->max   = max;
+}
+
+static int stats_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FrameStatsContext *s = ctx->priv;
+    ThreadData *td = arg;
+    SliceStats *ss = &s->slices[jobnr];
+    const int start = (s->rows *  jobnr     ) / nb_jobs;
+    const int end   = (s->rows * (jobnr + 1)) / nb_jobs;
+
+    if (s->depth > 8)
+        luma_stats16(s, ss, td, start, end);
+    else
+        luma_stats8(s, ss, td, s->histograms[jobnr], start, end);
+    emms_c();
+
+    return 0;
+}
+
+/* average of the analysed samples of a luma line or column */
+static int line_average(const FrameStatsContext *s, const uint8_t *src,
+                        ptrdiff_t stride, int len)
+{
+    uint64_t total = 0;
+
+    if (s->depth > 8) {
+        const uint16_t *src16 = (const uint16_t *)src;
+        stride /= 2;
+        for (int i = 0; i < len; i++)
+            total += src16[i * stride];
+    } else {
+        for (int i = 0; i < len; i++)
+            total += src[i * stride];
+    }
+
+    return total / len;
+}
+
+/* scan inwards from the edges for lines whose average is above the limit,
+ * as cropdetect does */
+static void find_crop(const FrameStatsContext *s, const AVFrame *in,
+                      int *x1, int *x2, int *y1, int *y2)
+{
+    const ptrdiff_t linesize = in->linesize[0] * s->step;
+    const int bps = 1 + (s->depth > 8);
+    const uint8_t *src = in->data[0];
+    int first, last, x;
+
+    for (first = 0; first < s->rows; first++)
+        if (line_average(s, src + first * linesize, bps, s->width) > s->limit_i)
+            break;
+    if (first == s->rows)
+        return;
+    for (last = s->rows - 1; last > first; last--)
+        if (line_average(s, src + last * linesize, bps, s->width) > s->limit_i)
+            break;
+    *y1 = first * s->step;
+    *y2 = last  * s->step;
+
+    for (x = 0; x < s->width; x++)
+        if (line_average(s, src + x * bps, linesize, s->rows) > s->limit_i)
+            break;
+    *x1 = x;
+    for (x = s->width - 1; x > *x1; x--)
+        if (line_average(s, src + x * bps, linesize, s->rows) > s->limit_i)
+            break;
+    *x2 = x;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, double value)
+{
+    char buf[32];
+
+    snprintf(buf, sizeof(buf), "%f", value);
+    av_dict_set(metadata, key, buf, 0);
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    FrameStatsContext *s = ctx->priv;
+    AVDictionary **metadata = &in->metadata;
+    const int width = s->width;
+    const int rows = s->rows;
+    const uint64_t count = (uint64_t)width * rows;
+    uint64_t sum = 0, black = 0, sad = 0;
+    int min = INT_MAX, max = 0;
+    int x1 = width - 1, x2 = 0, y1 = inlink->h - 1, y2 = 0;
+    ThreadData td;
+
+    td.in   = in;
+    td.prev = s->prev_picref;
+    ctx->internal->execute(ctx, stats_slice, &td, NULL, s->nb_jobs);
+
+    for (int i = 0; i < s->nb_jobs; i++) {
+        const SliceStats *ss = &s->slices[i];
+
+        sum   += ss->sum;
+        black += ss->black;
+        sad   += ss->sad;
+        min    = FFMIN(min, ss->min);
+        max    = FFMAX(max, ss->max);
+    }
+
+    find_crop(s, in, &x1, &x2, &y1, &y2);
+
+    av_dict_set_int(metadata, "lavfi.framestats.ymin", min, 0);
+    av_dict_set_int(metadata, "lavfi.framestats.ymax", max, 0);
+    set_meta(metadata, "lavfi.framestats.yavg", (double)sum / count);
+    set_meta(metadata, "lavfi.framestats.black_ratio", (double)black / count);
+    av_dict_set_int(metadata, "lavfi.framestats.crop_x1", x1, 0);
+    av_dict_set_int(metadata, "lavfi.framestats.crop_x2", x2, 0);
+    av_dict_set_int(metadata, "lavfi.framestats.crop_y1", y1, 0);
+    av_dict_set_int(metadata, "lavfi.framestats.crop_y2", y2, 0);
+
+    if (s->prev_picref) {
+        double mafd, diff, score;
+
+        /* scene score, using the formula of select */
+        mafd  = (double)sad / count / (1ULL << (s->depth - 8));
+        diff  = fabs(mafd - s->prev_mafd);
+        score = av_clipf(FFMIN(mafd, diff) / 100., 0, 1);
+        s->prev_mafd = mafd;
+
+        set_meta(metadata, "lavfi.framestats.mafd", mafd / 256);
+        set_meta(metadata, "lavfi.framestats.scene_score", score);
+    } else {
+        set_meta(metadata, "lavfi.framestats.scene_score", 0);
+    }
+
+    av_log(ctx, AV_LOG_DEBUG, "ymin:%d ymax:%d black:%"PRIu64" sad:%"PRIu64" crop:%d:%d:%d:%d\n",
+           min, max, black, sad, x1, x2, y1, y2);
+
+    av_frame_free(&s->prev_picref);
+    s->prev_picref = av_frame_clone(in);
+    if (!s->prev_picref) {
+        av_frame_free(&in);
+        return AVERROR(ENOMEM);
+    }
+
+    return ff_filter_frame(ctx->outputs[0], in);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    FrameStatsContext *s = ctx->priv;
+
+    av_frame_free(&s->prev_picref);
+    av_freep(&s->slices);
+    av_freep(&s->histograms);
+}
+
+static const AVFilterPad framestats_inputs[] = {
+    {
+        .name         = "default",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
+        .filter_frame = filter_frame,
+    },
+    { NULL }
+};
+
+static const AVFilterPad framestats_outputs[] = {
+    {
+        .name = "default",
+        .type = AVMEDIA_TYPE_VIDEO,
+    },
+    { NULL }
+};
+
+AVFilter ff_vf_framestats = {
+    .name          = "framestats",
+    .description   = NULL_IF_CONFIG_SMALL("Compute black, crop, freeze and scene change statistics in one pass."),
+    .priv_size     = sizeof(FrameStatsContext),
+    .priv_class    = &framestats_class,
+    .query_formats = query_formats,
+    .uninit        = uninit,
+    .inputs        = framestats_inputs,
+    .outputs       = framestats_outputs,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_SLICE_THREADS,
+};
@@ -32,6 +32,7 @@
 #include "libavutil/avstring.h"
 #include "libavutil/pixdesc.h"
 #include "libavutil/imgutils.h"
+#include "libavutil/intreadwrite.h"
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
@@ -85,6 +86,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     ff_framesync_uninit(&s->fs);
     av_expr_free(s->x_pexpr); s->x_pexpr = NULL;
     av_expr_free(s->y_pexpr); s->y_pexpr = NULL;
+    av_freep(&s->alpha_span);
 }
 
 static inline int normalize_xy(double d, int chroma_sub)
@@ -350,6 +352,66 @@ static int config_output(AVFilterLink *outlink)
 // ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)) is a faster version of: 255 * (x + y)
 #define UNPREMULTIPLY_ALPHA(x, y) ((((x) << 16) - ((x) << 9) + (x)) / ((((x) + (y)) << 8) - ((x) + (y)) - (y) * (x)))
 
+/**
+ * Find the non transparent part of each row of the overlay, so that the
+ * blending functions can skip the pixels which would leave main unchanged.
+ * Rows without any visible pixel get an empty span (start > end).
+ */
+static int compute_alpha_span(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    OverlayContext *s = ctx->priv;
+    const AVFrame *src = arg;
+    const AVComponentDescriptor *comp = &av_pix_fmt_desc_get(src->format)->comp[3];
+    const int w = src->width;
+    const int plane  = comp->plane;
+    const int offset = comp->offset;
+    const int step   = comp->step;
+    const int slice_start = (src->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (src->height * (jobnr+1)) / nb_jobs;
+    int y, x0, x1;
+
+    for (y = slice_start; y < slice_end; y++) {
+        const uint8_t *a = src->data[plane] + y * src->linesize[plane] + offset;
+
+        x0 = 0;
+        x1 = w;
+        if (step == 1) {
+            while (x0 + 8 <= w && !AV_RN64(a + x0))
+                x0 += 8;
+            while (x1 - 8 >= x0 && !AV_RN64(a + x1 - 8))
+                x1 -= 8;
+        }
+        while (x0 < x1 && !a[x0 * step])
+            x0++;
+        while (x1 > x0 && !a[(x1 - 1) * step])
+            x1--;
+
+        s->alpha_span[2 * y    ] = x0 < x1 ? x0 : w;
+        s->alpha_span[2 * y + 1] = x0 < x1 ? x1 : 0;
+    }
+    return 0;
+}
+
+/**
+ * Get the columns [start, end) of row j of a plane subsampled by hsub/vsub
+ * which may be covered by a non transparent part of the overlay.
+ */
+static av_always_inline void get_alpha_span(const OverlayContext *s, int src_h,
+                                            int j, int hsub, int vsub,
+                                            int *start, int *end)
+{
+    int y    = j << vsub;
+    int yend = FFMIN((j + 1) << vsub, src_h);
+    int x0 = INT_MAX, x1 = 0;
+
+    for (; y < yend; y++) {
+        x0 = FFMIN(x0, s->alpha_span[2 * y    ]);
+        x1 = FFMAX(x1, s->alpha_span[2 * y + 1]);
+    }
+    *start = x0 >> hsub;
+    *end   = (x1 + (1 << hsub) - 1) >> hsub;
+}
+
 /**
  * Blend image in src to destination buffer dst at position (x, y).
  */
@@ -390,10 +452,18 @@ static av_always_inline void blend_slice_packed_rgb(AVFilterContext *ctx,
 
     for (i = slice_start; i < slice_end; i++) {
         j = FFMAX(-x, 0);
+        jmax = FFMIN(-x + dst_w, src_w);
+        if (s->use_spans) {
+            int start, end;
+
+            get_alpha_span(s, src_h, i, 0, 0, &start, &end);
+            j    = FFMAX(j, start);
+            jmax = FFMIN(jmax, end);
+        }
         S = sp + j     * sstep;
         d = dp + (x+j) * dstep;
 
-        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
+        for (; j < jmax; j++) {
             alpha = S[sa];
 
             // if the main channel has an alpha channel, alpha has to be calculated
@@ -482,13 +552,21 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
 
     for (j = slice_start; j < slice_end; j++) {
         k = FFMAX(-xp, 0);
+        kmax = FFMIN(-xp + dst_wp, src_wp);
+        // with straight alpha, a transparent pixel leaves main unchanged
+        if (octx->use_spans && straight) {
+            int start, end;
+
+            get_alpha_span(octx, src_h, j, hsub, vsub, &start, &end);
+            k    = FFMAX(k, start);
+            kmax = FFMIN(kmax, end);
+        }
         d = dp + (xp+k) * dst_step;
         s = sp + k;
         a = ap + (k<<hsub);
         da = dap + ((xp+k) << hsub);
-        kmax = FFMIN(-xp + dst_wp, src_wp);
 
-        if (((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i]) {
+        if (((vsub && j+1 < src_hp) || !vsub) && octx->blend_row[i] && k < kmax) {
             int c = octx->blend_row[i](d, da, s, a, kmax - k, src->linesize[3]);
 
             s += c;
@@ -550,7 +628,8 @@ static av_always_inline void blend_plane(AVFilterContext *ctx,
     }
 }
 
-static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
+static inline void alpha_composite(const OverlayContext *octx,
+                                   const AVFrame *src, const AVFrame *dst,
                                    int src_w, int src_h,
                                    int dst_w, int dst_h,
                                    int x, int y,
@@ -571,10 +650,18 @@ static inline void alpha_composite(const AVFrame *src, const AVFrame *dst,
 
     for (i = i + slice_start; i < slice_end; i++) {
         j = FFMAX(-x, 0);
+        jmax = FFMIN(-x + dst_w, src_w);
+        if (octx->use_spans) {
+            int start, end;
+
+            get_alpha_span(octx, src_h, i, 0, 0, &start, &end);
+            j    = FFMAX(j, start);
+            jmax = FFMIN(jmax, end);
+        }
         s = sa + j;
         d = da + x+j;
 
-        for (jmax = FFMIN(-x + dst_w, src_w); j < jmax; j++) {
+        for (; j < jmax; j++) {
             alpha = *s;
             if (alpha != 0 && alpha != 255) {
                 uint8_t alpha_d = *d;
@@ -623,7 +710,7 @@ static av_always_inline void blend_slice_yuv(AVFilterContext *ctx,
                 jobnr, nb_jobs);
 
     if (main_has_alpha)
-        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
+        alpha_composite(s, src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
 }
 
 static av_always_inline void blend_slice_planar_rgb(AVFilterContext *ctx,
@@ -652,7 +739,7 @@ static av_always_inline void blend_slice_planar_rgb(AVFilterContext *ctx,
                 jobnr, nb_jobs);
 
     if (main_has_alpha)
-        alpha_composite(src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
+        alpha_composite(s, src, dst, src_w, src_h, dst_w, dst_h, x, y, jobnr, nb_jobs);
 }
 
 static int blend_slice_yuv420(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -967,6 +1054,17 @@ static int do_blend(FFFrameSync *fs)
 
         td.dst = mainpic;
         td.src = second;
+
+        s->use_spans = 0;
+        if (s->skip_transparent) {
+            av_fast_malloc(&s->alpha_span, &s->alpha_span_size,
+                           2 * second->height * sizeof(*s->alpha_span));
+            if (s->alpha_span) {
+                ctx->internal->execute(ctx, compute_alpha_span, second, NULL,
+                                       FFMIN(second->height, ff_filter_get_nb_threads(ctx)));
+                s->use_spans = 1;
+            }
+        }
         ctx->internal->execute(ctx, s->blend_slice, &td, NULL, FFMIN(FFMAX(1, FFMIN3(s->y + second->height, FFMIN(second->height, mainpic->height), mainpic->height - s->y)),
                                                                      ff_filter_get_nb_threads(ctx)));
     }
@@ -1014,6 +1112,7 @@ static const AVOption overlay_options[] = {
     { "alpha", "alpha format", OFFSET(alpha_format), AV_OPT_TYPE_INT, {.i64=0}, 0, 1, FLAGS, "alpha_format" },
         { "straight",      "", 0, AV_OPT_TYPE_CONST, {.i64=0}, .flags = FLAGS, .unit = "alpha_format" },
         { "premultiplied", "", 0, AV_OPT_TYPE_CONST, {.i64=1}, .flags = FLAGS, .unit = "alpha_format" },
+    { "skip_transparent", "skip fully transparent parts of the overlay", OFFSET(skip_transparent), AV_OPT_TYPE_BOOL, {.i64=1}, 0, 1, FLAGS },
     { NULL }
 };
 
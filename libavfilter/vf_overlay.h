@@ -62,6 +62,7 @@ typedef struct OverlayContext {
     int format;                 ///< OverlayFormat
     int alpha_format;
     int eval_mode;              ///< EvalMode
+    int skip_transparent;       ///< skip fully transparent parts of the overlay
 
     FFFrameSync fs;
 
@@ -75,6 +76,10 @@ typedef struct OverlayContext {
 
     AVExpr *x_pexpr, *y_pexpr;
 
+    int use_spans;              ///< alpha_span is valid for the current overlay frame
+    int *alpha_span;            ///< first and last+1 non transparent column of each overlay row
+    unsigned int alpha_span_size;
+
     int (*blend_row[4])(uint8_t *d, uint8_t *da, uint8_t *s, uint8_t *a, int w,
                         ptrdiff_t alinesize);
     int (*blend_slice)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
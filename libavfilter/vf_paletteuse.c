@@ -27,6 +27,8 @@
 #include "libavutil/internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
+#include "libavutil/thread.h"
+#include <stdatomic.h>
 #include "avfilter.h"
 #include "filters.h"
 #include "framesync.h"
@@ -77,13 +79,18 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                              int x_start, int y_start, int width, int height);
+typedef int (*set_frame_func)(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs);
+
+typedef struct ThreadData {
+    AVFrame *out, *in;
+    int x_start, y_start, width, height;
+} ThreadData;
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node *cache;               /* lookup caches, CACHE_SIZE nodes per thread */
+    int nb_caches;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
@@ -98,6 +105,15 @@ typedef struct PaletteUseContext {
     AVFrame *last_in;
     AVFrame *last_out;
 
+    /* error diffusion wavefront: pixels of each row already dithered */
+    atomic_int *row_progress;
+    int *job_ret;
+#if HAVE_THREADS
+    pthread_mutex_t progress_mutex;
+    pthread_cond_t progress_cond;
+    int progress_init;
+#endif
+
     /* debug options */
     char *dot_filename;
     int color_search_method;
@@ -338,8 +354,8 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
-                                      uint8_t a, uint8_t r, uint8_t g, uint8_t b,
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color, uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
     int i;
@@ -348,7 +364,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -372,7 +388,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +397,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -391,24 +407,91 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
-                                      int x_start, int y_start, int w, int h,
+#define PROGRESS_STEP 32
+
+#if HAVE_THREADS
+static void wait_row(PaletteUseContext *s, int row, int count)
+{
+    if (atomic_load_explicit(&s->row_progress[row], memory_order_acquire) >= count)
+        return;
+    pthread_mutex_lock(&s->progress_mutex);
+    while (atomic_load_explicit(&s->row_progress[row], memory_order_acquire) < count)
+        pthread_cond_wait(&s->progress_cond, &s->progress_mutex);
+    pthread_mutex_unlock(&s->progress_mutex);
+}
+
+static void report_row(PaletteUseContext *s, int row, int count)
+{
+    pthread_mutex_lock(&s->progress_mutex);
+    atomic_store_explicit(&s->row_progress[row], count, memory_order_release);
+    pthread_cond_broadcast(&s->progress_cond);
+    pthread_mutex_unlock(&s->progress_mutex);
+}
+#else
+static void wait_row(PaletteUseContext *s, int row, int count) {}
+static void report_row(PaletteUseContext *s, int row, int count) {}
+#endif
+
+/**
+ * Number of pixels the previous row has to be ahead of the current one so
+ * that every pixel receives all the error from the previous row before any
+ * error from its own row, which keeps the clipping order of the serial scan.
+ */
+static av_always_inline int diffusion_lag(enum dithering_mode dither)
+{
+    switch (dither) {
+    case DITHERING_HECKBERT: return 1;
+    case DITHERING_SIERRA2:  return 4;
+    default:                 return 2;
+    }
+}
+
+/**
+ * Error diffusion modes are threaded as a wavefront: rows are interleaved
+ * between the jobs and each row follows the one above it. The other modes
+ * simply split the rows in slices.
+ */
+static av_always_inline int set_frame(PaletteUseContext *s, ThreadData *td,
+                                      int jobnr, int nb_jobs,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
 {
-    int x, y;
+    int x, y, y0, y1, ystep, ret = 0;
+    AVFrame *in = td->in, *out = td->out;
+    const int x_start = td->x_start, y_start = td->y_start;
+    const int w = x_start + td->width;
+    const int h = y_start + td->height;
+    const int diffusion = dither != DITHERING_NONE && dither != DITHERING_BAYER;
+    const int wavefront = diffusion && nb_jobs > 1;
     const int src_linesize = in ->linesize[0] >> 2;
     const int dst_linesize = out->linesize[0];
-    uint32_t *src = ((uint32_t *)in ->data[0]) + y_start*src_linesize;
-    uint8_t  *dst =              out->data[0]  + y_start*dst_linesize;
+    struct cache_node *cache = s->cache + jobnr * CACHE_SIZE;
 
-    w += x_start;
-    h += y_start;
+    if (diffusion) {
+        y0    = y_start + jobnr;
+        y1    = h;
+        ystep = nb_jobs;
+    } else {
+        y0    = y_start + td->height *  jobnr      / nb_jobs;
+        y1    = y_start + td->height * (jobnr + 1) / nb_jobs;
+        ystep = 1;
+    }
+
+    for (y = y0; y < y1; y += ystep) {
+        uint32_t *src = ((uint32_t *)in ->data[0]) + y*src_linesize;
+        uint8_t  *dst =              out->data[0]  + y*dst_linesize;
 
-    for (y = y_start; y < h; y++) {
         for (x = x_start; x < w; x++) {
             int er, eg, eb;
 
+            if (wavefront && !((x - x_start) % PROGRESS_STEP)) {
+                if (x > x_start)
+                    report_row(s, y - y_start, x - x_start);
+                if (y > y_start)
+                    wait_row(s, y - 1 - y_start,
+                             FFMIN(x + PROGRESS_STEP + diffusion_lag(dither), w) - x_start);
+            }
+
             if (dither == DITHERING_BAYER) {
                 const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
                 const uint8_t a8 = src[x] >> 24 & 0xff;
@@ -418,18 +501,22 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = av_clip_uint8(r8 + d);
                 const uint8_t g = av_clip_uint8(g8 + d);
                 const uint8_t b = av_clip_uint8(b8 + d);
-                const int color = color_get(s, src[x], a8, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a8, r, g, b, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 3, 3);
@@ -438,10 +525,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 7, 4);
@@ -452,10 +541,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)          src[                 x + 1] = dither_color(src[                 x + 1], er, eg, eb, 4, 4);
@@ -471,10 +562,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &er, &eg, &eb, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
 
                 if (right)         src[               x + 1] = dither_color(src[               x + 1], er, eg, eb, 2, 2);
@@ -486,17 +579,26 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
-                if (color < 0)
-                    return color;
+                if (color < 0) {
+                    ret = color;
+                    goto end;
+                }
                 dst[x] = color;
             }
         }
-        src += src_linesize;
-        dst += dst_linesize;
+        if (wavefront)
+            report_row(s, y - y_start, w - x_start);
     }
-    return 0;
+
+end:
+    /* do not leave the jobs below waiting on rows that will never be done */
+    if (ret < 0 && wavefront) {
+        for (; y < y1; y += ystep)
+            report_row(s, y - y_start, w - x_start);
+    }
+    return ret;
 }
 
 #define INDENT 4
@@ -896,7 +998,8 @@ static void set_processing_window(enum diff_mode diff_mode,
 
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
-    int x, y, w, h, ret;
+    int x, y, w, h, i, ret, nb_jobs;
+    ThreadData td;
     AVFilterContext *ctx = inlink->dst;
     PaletteUseContext *s = ctx->priv;
     AVFilterLink *outlink = inlink->dst->outputs[0];
@@ -923,7 +1026,26 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    /* bayer looks up the cache with the undithered color, so its result
+     * depends on the scan order and it has to stay on a single thread */
+    nb_jobs = s->dither == DITHERING_BAYER ? 1 : FFMIN(h, s->nb_caches);
+    /* the error diffusion wavefront needs all its jobs running at once */
+    if (s->dither != DITHERING_NONE && !ff_filter_execute_is_concurrent(ctx))
+        nb_jobs = 1;
+    for (i = 0; i < h; i++)
+        atomic_init(&s->row_progress[i], 0);
+
+    td.out = out;
+    td.in = in;
+    td.x_start = x;
+    td.y_start = y;
+    td.width = w;
+    td.height = h;
+    ctx->internal->execute(ctx, s->set_frame, &td, s->job_ret, nb_jobs);
+
+    ret = 0;
+    for (i = 0; i < nb_jobs; i++)
+        ret = FFMIN(ret, s->job_ret[i]);
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -936,12 +1058,42 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     return 0;
 }
 
+static void free_caches(PaletteUseContext *s)
+{
+    for (int i = 0; i < s->nb_caches * CACHE_SIZE; i++)
+        av_freep(&s->cache[i].entries);
+}
+
 static int config_output(AVFilterLink *outlink)
 {
     int ret;
     AVFilterContext *ctx = outlink->src;
     PaletteUseContext *s = ctx->priv;
 
+    free_caches(s);
+    av_freep(&s->cache);
+    av_freep(&s->job_ret);
+    av_freep(&s->row_progress);
+    s->nb_caches = ff_filter_get_nb_threads(ctx);
+    s->cache = av_calloc(s->nb_caches * CACHE_SIZE, sizeof(*s->cache));
+    s->job_ret = av_calloc(s->nb_caches, sizeof(*s->job_ret));
+    s->row_progress = av_calloc(ctx->inputs[0]->h, sizeof(*s->row_progress));
+    if (!s->cache || !s->job_ret || !s->row_progress) {
+        s->nb_caches = 0;
+        return AVERROR(ENOMEM);
+    }
+#if HAVE_THREADS
+    if (!s->progress_init) {
+        if ((ret = pthread_mutex_init(&s->progress_mutex, NULL)))
+            return AVERROR(ret);
+        if ((ret = pthread_cond_init(&s->progress_cond, NULL))) {
+            pthread_mutex_destroy(&s->progress_mutex);
+            return AVERROR(ret);
+        }
+        s->progress_init = 1;
+    }
+#endif
+
     ret = ff_framesync_init_dualinput(&s->fs, ctx);
     if (ret < 0)
         return ret;
@@ -984,9 +1136,8 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
-            av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        free_caches(s);
+        memset(s->cache, 0, s->nb_caches * CACHE_SIZE * sizeof(*s->cache));
     }
 
     i = 0;
@@ -1034,10 +1185,10 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
-                            int x_start, int y_start, int w, int h)             \
+static int set_frame_##name(AVFilterContext *ctx, void *arg,                    \
+                            int jobnr, int nb_jobs)                             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(ctx->priv, arg, jobnr, nb_jobs, value, color_search);      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1108,12 +1259,20 @@ static int activate(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
-        av_freep(&s->cache[i].entries);
+    if (s->cache)
+        free_caches(s);
+    av_freep(&s->cache);
+    av_freep(&s->job_ret);
+    av_freep(&s->row_progress);
+#if HAVE_THREADS
+    if (s->progress_init) {
+        pthread_mutex_destroy(&s->progress_mutex);
+        pthread_cond_destroy(&s->progress_cond);
+    }
+#endif
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1150,4 +1309,5 @@ AVFilter ff_vf_paletteuse = {
     .inputs        = paletteuse_inputs,
     .outputs       = paletteuse_outputs,
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
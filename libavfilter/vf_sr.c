@@ -46,6 +46,10 @@ typedef struct SRContext {
     int scale_factor;
     struct SwsContext *sws_contexts[3];
     int sws_slice_h, sws_input_linesize, sws_output_linesize;
+    int batch_size;
+    // output frames waiting for the model to run on a full batch
+    AVFrame **pending;
+    int nb_pending;
 } SRContext;
 
 #define OFFSET(x) offsetof(SRContext, x)
@@ -58,6 +62,7 @@ static const AVOption sr_options[] = {
 #endif
     { "scale_factor", "scale factor for SRCNN model", OFFSET(scale_factor), AV_OPT_TYPE_INT, { .i64 = 2 }, 2, 4, FLAGS },
     { "model", "path to model file specifying network architecture and its parameters", OFFSET(model_filename), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
+    { "batch_size", "number of frames to run through the model at once", OFFSET(batch_size), AV_OPT_TYPE_INT, { .i64 = 1 }, 1, 64, FLAGS },
     { NULL }
 };
 
@@ -81,13 +86,19 @@ static av_cold int init(AVFilterContext *context)
         av_log(context, AV_LOG_ERROR, "load_model for network was not specified\n");
         return AVERROR(EIO);
     }
-    sr_context->model = (sr_context->dnn_module->load_model)(sr_context->model_filename);
+    sr_context->model = (sr_context->dnn_module->load_model)(sr_context->model_filename,
+                                                             ff_filter_get_nb_threads(context));
     if (!sr_context->model){
         av_log(context, AV_LOG_ERROR, "could not load DNN model\n");
         return AVERROR(EIO);
     }
 
+    sr_context->pending = av_calloc(sr_context->batch_size, sizeof(*sr_context->pending));
+    if (!sr_context->pending)
+        return AVERROR(ENOMEM);
+
     sr_context->input.dt = DNN_FLOAT;
+    sr_context->input.batch_size = sr_context->batch_size;
     sr_context->sws_contexts[0] = NULL;
     sr_context->sws_contexts[1] = NULL;
     sr_context->sws_contexts[2] = NULL;
@@ -196,13 +207,47 @@ static int config_props(AVFilterLink *inlink)
     return 0;
 }
 
+static int flush_pending(AVFilterContext *context)
+{
+    SRContext *sr_context = context->priv;
+    AVFilterLink *outlink = context->outputs[0];
+    int nb_pending = sr_context->nb_pending;
+    int ret = 0;
+    DNNReturnType dnn_result;
+
+    sr_context->nb_pending = 0;
+    dnn_result = (sr_context->dnn_module->execute_model)(sr_context->model, &sr_context->output, 1);
+    if (dnn_result != DNN_SUCCESS){
+        av_log(context, AV_LOG_ERROR, "failed to execute loaded model\n");
+        ret = AVERROR(EIO);
+    }
+
+    for (int i = 0; i < nb_pending; ++i){
+        AVFrame *out = sr_context->pending[i];
+        sr_context->pending[i] = NULL;
+        if (ret < 0){
+            av_frame_free(&out);
+            continue;
+        }
+        sws_scale(sr_context->sws_contexts[2],
+                  (const uint8_t *[4]){(const uint8_t *)sr_context->output.data +
+                                       (size_t)i * sr_context->sws_output_linesize * out->height, 0, 0, 0},
+                  (const int[4]){sr_context->sws_output_linesize, 0, 0, 0},
+                  0, out->height, (uint8_t * const*)out->data, out->linesize);
+        ret = ff_filter_frame(outlink, out);
+    }
+
+    return ret;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *context = inlink->dst;
     SRContext *sr_context = context->priv;
     AVFilterLink *outlink = context->outputs[0];
     AVFrame *out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
-    DNNReturnType dnn_result;
+    uint8_t *input_data = (uint8_t *)sr_context->input.data +
+                          (size_t)sr_context->nb_pending * sr_context->sws_input_linesize * sr_context->input.height;
 
     if (!out){
         av_log(context, AV_LOG_ERROR, "could not allocate memory for output frame\n");
@@ -217,7 +262,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
                   0, sr_context->sws_slice_h, out->data, out->linesize);
 
         sws_scale(sr_context->sws_contexts[1], (const uint8_t **)out->data, out->linesize,
-                  0, out->height, (uint8_t * const*)(&sr_context->input.data),
+                  0, out->height, (uint8_t * const*)(&input_data),
                   (const int [4]){sr_context->sws_input_linesize, 0, 0, 0});
     } else {
         if (sr_context->sws_contexts[0]){
@@ -228,22 +273,28 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
 
         sws_scale(sr_context->sws_contexts[1], (const uint8_t **)in->data, in->linesize,
-                  0, in->height, (uint8_t * const*)(&sr_context->input.data),
+                  0, in->height, (uint8_t * const*)(&input_data),
                   (const int [4]){sr_context->sws_input_linesize, 0, 0, 0});
     }
     av_frame_free(&in);
 
-    dnn_result = (sr_context->dnn_module->execute_model)(sr_context->model, &sr_context->output, 1);
-    if (dnn_result != DNN_SUCCESS){
-        av_log(context, AV_LOG_ERROR, "failed to execute loaded model\n");
-        return AVERROR(EIO);
-    }
+    sr_context->pending[sr_context->nb_pending++] = out;
+    if (sr_context->nb_pending < sr_context->batch_size)
+        return 0;
 
-    sws_scale(sr_context->sws_contexts[2], (const uint8_t *[4]){(const uint8_t *)sr_context->output.data, 0, 0, 0},
-              (const int[4]){sr_context->sws_output_linesize, 0, 0, 0},
-              0, out->height, (uint8_t * const*)out->data, out->linesize);
+    return flush_pending(context);
+}
+
+static int request_frame(AVFilterLink *outlink)
+{
+    AVFilterContext *context = outlink->src;
+    SRContext *sr_context = context->priv;
+    int ret = ff_request_frame(context->inputs[0]);
 
-    return ff_filter_frame(outlink, out);
+    if (ret == AVERROR_EOF && sr_context->nb_pending)
+        ret = flush_pending(context);
+
+    return ret;
 }
 
 static av_cold void uninit(AVFilterContext *context)
@@ -259,6 +310,12 @@ static av_cold void uninit(AVFilterContext *context)
     for (i = 0; i < 3; ++i){
         sws_freeContext(sr_context->sws_contexts[i]);
     }
+
+    if (sr_context->pending){
+        for (i = 0; i < sr_context->nb_pending; ++i)
+            av_frame_free(&sr_context->pending[i]);
+        av_freep(&sr_context->pending);
+    }
 }
 
 static const AVFilterPad sr_inputs[] = {
@@ -273,8 +330,9 @@ static const AVFilterPad sr_inputs[] = {
 
 static const AVFilterPad sr_outputs[] = {
     {
-        .name = "default",
-        .type = AVMEDIA_TYPE_VIDEO,
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .request_frame = request_frame,
     },
     { NULL }
 };
@@ -60,6 +60,21 @@ static const struct LumaCoefficients luma_coefficients[AVCOL_SPC_NB] = {
     [AVCOL_SPC_BT2020_CL]  = { 0.2627, 0.6780, 0.0593 },
 };
 
+#define LUT_SIZE 4096
+
+/* the exact curves keep the precision of the per-pixel code they replace,
+ * double where it computed in double */
+typedef struct TonemapCurve {
+    double param;
+    double peak;
+    double gamma;       ///< exponent of the gamma curve
+    double gamma_low;   ///< value of the gamma curve at 0.05, linear below
+    float hable_peak;   ///< hable(peak)
+    float j;            ///< mobius knee
+    float a, b;         ///< mobius coefficients
+    float mobius_scale;
+} TonemapCurve;
+
 typedef struct TonemapContext {
     const AVClass *class;
 
@@ -67,8 +82,17 @@ typedef struct TonemapContext {
     double param;
     double desat;
     double peak;
+    int lut;
 
     const struct LumaCoefficients *coeffs;
+
+    TonemapCurve curve;
+    void (*tonemap_row)(const struct TonemapContext *s,
+                        float *r, float *g, float *b, int w);
+
+    float *lut_data;    ///< tone curve sampled at range * (i / LUT_SIZE)^2
+    float lut_scale;    ///< LUT_SIZE^2 / range
+    double lut_peak;    ///< peak the lut was built for
 } TonemapContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -107,94 +131,133 @@ static av_cold int init(AVFilterContext *ctx)
     return 0;
 }
 
-static float hable(float in)
+static av_always_inline float hable(float in)
 {
     float a = 0.15f, b = 0.50f, c = 0.10f, d = 0.20f, e = 0.02f, f = 0.30f;
     return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
 }
 
-static float mobius(float in, float j, double peak)
+static void set_curve(TonemapContext *s, double peak)
 {
-    float a, b;
-
-    if (in <= j)
-        return in;
-
-    a = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
-    b = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
-
-    return (b * b + 2.0f * b * j + j * j) / (b - a) * (in + a) / (in + b);
+    TonemapCurve *c = &s->curve;
+    float j = s->param;
+
+    c->param        = s->param;
+    c->peak         = peak;
+    c->gamma        = 1.0f / s->param;
+    c->gamma_low    = pow(0.05f / peak, c->gamma);
+    c->hable_peak   = hable(peak);
+    c->j            = j;
+    c->a            = -j * j * (peak - 1.0f) / (j * j - 2.0f * j + peak);
+    c->b            = (j * j - 2.0f * j * peak + peak) / FFMAX(peak - 1.0f, 1e-6);
+    c->mobius_scale = (c->b * c->b + 2.0f * c->b * j + j * j) / (c->b - c->a);
 }
 
-#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
-static void tonemap(TonemapContext *s, AVFrame *out, const AVFrame *in,
-                    const AVPixFmtDescriptor *desc, int x, int y, double peak)
+/* branch-free where possible, so the row loops below can be vectorized
+ * once the algorithm is a compile time constant */
+static av_always_inline float tonemap_curve(const TonemapCurve *c,
+                                            enum TonemapAlgorithm algo, float sig)
 {
-    const float *r_in = (const float *)(in->data[0] + x * desc->comp[0].step + y * in->linesize[0]);
-    const float *b_in = (const float *)(in->data[1] + x * desc->comp[1].step + y * in->linesize[1]);
-    const float *g_in = (const float *)(in->data[2] + x * desc->comp[2].step + y * in->linesize[2]);
-    float *r_out = (float *)(out->data[0] + x * desc->comp[0].step + y * out->linesize[0]);
-    float *b_out = (float *)(out->data[1] + x * desc->comp[1].step + y * out->linesize[1]);
-    float *g_out = (float *)(out->data[2] + x * desc->comp[2].step + y * out->linesize[2]);
-    float sig, sig_orig;
-
-    /* load values */
-    *r_out = *r_in;
-    *b_out = *b_in;
-    *g_out = *g_in;
-
-    /* desaturate to prevent unnatural colors */
-    if (s->desat > 0) {
-        float luma = s->coeffs->cr * *r_in + s->coeffs->cg * *g_in + s->coeffs->cb * *b_in;
-        float overbright = FFMAX(luma - s->desat, 1e-6) / FFMAX(luma, 1e-6);
-        *r_out = MIX(*r_in, luma, overbright);
-        *g_out = MIX(*g_in, luma, overbright);
-        *b_out = MIX(*b_in, luma, overbright);
-    }
-
-    /* pick the brightest component, reducing the value range as necessary
-     * to keep the entire signal in range and preventing discoloration due to
-     * out-of-bounds clipping */
-    sig = FFMAX(FFMAX3(*r_out, *g_out, *b_out), 1e-6);
-    sig_orig = sig;
-
-    switch(s->tonemap) {
+    switch(algo) {
     default:
     case TONEMAP_NONE:
-        // do nothing
-        break;
+        return sig;
     case TONEMAP_LINEAR:
-        sig = sig * s->param / peak;
-        break;
+        return sig * c->param / c->peak;
     case TONEMAP_GAMMA:
-        sig = sig > 0.05f ? pow(sig / peak, 1.0f / s->param)
-                          : sig * pow(0.05f / peak, 1.0f / s->param) / 0.05f;
-        break;
+        return sig > 0.05f ? pow(sig / c->peak, c->gamma) : sig * c->gamma_low / 0.05f;
     case TONEMAP_CLIP:
-        sig = av_clipf(sig * s->param, 0, 1.0f);
-        break;
+        return av_clipf(sig * c->param, 0, 1.0f);
     case TONEMAP_HABLE:
-        sig = hable(sig) / hable(peak);
-        break;
+        return hable(sig) / c->hable_peak;
     case TONEMAP_REINHARD:
-        sig = sig / (sig + s->param) * (peak + s->param) / peak;
-        break;
+        return sig / (sig + c->param) * (c->peak + c->param) / c->peak;
     case TONEMAP_MOBIUS:
-        sig = mobius(sig, s->param, peak);
-        break;
+        return sig <= c->j ? sig : c->mobius_scale * (sig + c->a) / (sig + c->b);
     }
+}
 
-    /* apply the computed scale factor to the color,
-     * linearly to prevent discoloration */
-    *r_out *= sig / sig_orig;
-    *g_out *= sig / sig_orig;
-    *b_out *= sig / sig_orig;
+/* pick the brightest component, reducing the value range as necessary
+ * to keep the entire signal in range and preventing discoloration due to
+ * out-of-bounds clipping, then apply the computed scale factor to the color,
+ * linearly to prevent discoloration */
+static av_always_inline void tonemap_row(const TonemapContext *s,
+                                         float *r, float *g, float *b, int w,
+                                         enum TonemapAlgorithm algo)
+{
+    const TonemapCurve *c = &s->curve;
+
+    for (int x = 0; x < w; x++) {
+        float sig  = FFMAX(FFMAX3(r[x], g[x], b[x]), 1e-6);
+        float gain = tonemap_curve(c, algo, sig) / sig;
+
+        r[x] *= gain;
+        g[x] *= gain;
+        b[x] *= gain;
+    }
 }
 
+#define DEFINE_TONEMAP_ROW(name, algo)                                      \
+static void tonemap_row_ ## name(const TonemapContext *s,                   \
+                                 float *r, float *g, float *b, int w)       \
+{                                                                           \
+    tonemap_row(s, r, g, b, w, algo);                                       \
+}
+
+DEFINE_TONEMAP_ROW(linear,   TONEMAP_LINEAR)
+DEFINE_TONEMAP_ROW(gamma,    TONEMAP_GAMMA)
+DEFINE_TONEMAP_ROW(clip,     TONEMAP_CLIP)
+DEFINE_TONEMAP_ROW(hable,    TONEMAP_HABLE)
+DEFINE_TONEMAP_ROW(reinhard, TONEMAP_REINHARD)
+DEFINE_TONEMAP_ROW(mobius,   TONEMAP_MOBIUS)
+
+static void tonemap_row_lut(const TonemapContext *s,
+                            float *r, float *g, float *b, int w)
+{
+    const float *lut = s->lut_data;
+    const float lut_scale = s->lut_scale;
+
+    for (int x = 0; x < w; x++) {
+        float sig = FFMAX(FFMAX3(r[x], g[x], b[x]), 1e-6);
+        float pos = sqrtf(sig * lut_scale);
+        float gain;
+
+        if (pos < LUT_SIZE) {
+            int i = pos;
+            gain = (lut[i] + (pos - i) * (lut[i + 1] - lut[i])) / sig;
+        } else {
+            gain = tonemap_curve(&s->curve, s->tonemap, sig) / sig;
+        }
+
+        r[x] *= gain;
+        g[x] *= gain;
+        b[x] *= gain;
+    }
+}
+
+static int build_lut(TonemapContext *s, double peak)
+{
+    double range = FFMAX(peak, 1.0);
+
+    if (!s->lut_data) {
+        s->lut_data = av_malloc_array(LUT_SIZE + 1, sizeof(*s->lut_data));
+        if (!s->lut_data)
+            return AVERROR(ENOMEM);
+    }
+
+    for (int i = 0; i <= LUT_SIZE; i++) {
+        double x = (double)i / LUT_SIZE;
+        s->lut_data[i] = tonemap_curve(&s->curve, s->tonemap, range * x * x);
+    }
+    s->lut_scale = LUT_SIZE * LUT_SIZE / range;
+    s->lut_peak  = peak;
+
+    return 0;
+}
+
+#define MIX(x,y,a) (x) * (1 - (a)) + (y) * (a)
 typedef struct ThreadData {
     AVFrame *in, *out;
-    const AVPixFmtDescriptor *desc;
-    double peak;
 } ThreadData;
 
 static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
@@ -203,14 +266,39 @@ static int tonemap_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs
     ThreadData *td = arg;
     AVFrame *in = td->in;
     AVFrame *out = td->out;
-    const AVPixFmtDescriptor *desc = td->desc;
     const int slice_start = (in->height * jobnr) / nb_jobs;
     const int slice_end = (in->height * (jobnr+1)) / nb_jobs;
-    double peak = td->peak;
+    const int width = out->width;
+    const double desat = s->desat;
+
+    for (int y = slice_start; y < slice_end; y++) {
+        const float *r_in = (const float *)(in->data[0] + y * in->linesize[0]);
+        const float *b_in = (const float *)(in->data[1] + y * in->linesize[1]);
+        const float *g_in = (const float *)(in->data[2] + y * in->linesize[2]);
+        float *r_out = (float *)(out->data[0] + y * out->linesize[0]);
+        float *b_out = (float *)(out->data[1] + y * out->linesize[1]);
+        float *g_out = (float *)(out->data[2] + y * out->linesize[2]);
+
+        /* desaturate to prevent unnatural colors */
+        if (desat > 0) {
+            const double cr = s->coeffs->cr, cg = s->coeffs->cg, cb = s->coeffs->cb;
+
+            for (int x = 0; x < width; x++) {
+                float luma = cr * r_in[x] + cg * g_in[x] + cb * b_in[x];
+                float overbright = FFMAX(luma - desat, 1e-6) / FFMAX(luma, 1e-6);
+                r_out[x] = MIX(r_in[x], luma, overbright);
+                g_out[x] = MIX(g_in[x], luma, overbright);
+                b_out[x] = MIX(b_in[x], luma, overbright);
+            }
+        } else {
+            memcpy(r_out, r_in, width * sizeof(*r_out));
+            memcpy(g_out, g_in, width * sizeof(*g_out));
+            memcpy(b_out, b_in, width * sizeof(*b_out));
+        }
 
-    for (int y = slice_start; y < slice_end; y++)
-        for (int x = 0; x < out->width; x++)
-            tonemap(s, out, in, desc, x, y, peak);
+        if (s->tonemap_row)
+            s->tonemap_row(s, r_out, g_out, b_out, width);
+    }
 
     return 0;
 }
@@ -270,11 +358,36 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         s->desat = 0;
     }
 
+    set_curve(s, peak);
+    /* linear and clip are cheaper than the table, and the kink of clip
+     * cannot be interpolated */
+    if (s->lut && s->tonemap != TONEMAP_NONE &&
+        s->tonemap != TONEMAP_LINEAR && s->tonemap != TONEMAP_CLIP) {
+        if (!s->lut_data || s->lut_peak != peak) {
+            ret = build_lut(s, peak);
+            if (ret < 0) {
+                av_frame_free(&in);
+                av_frame_free(&out);
+                return ret;
+            }
+        }
+        s->tonemap_row = tonemap_row_lut;
+    } else {
+        switch(s->tonemap) {
+        default:
+        case TONEMAP_NONE:     s->tonemap_row = NULL;                  break;
+        case TONEMAP_LINEAR:   s->tonemap_row = tonemap_row_linear;    break;
+        case TONEMAP_GAMMA:    s->tonemap_row = tonemap_row_gamma;     break;
+        case TONEMAP_CLIP:     s->tonemap_row = tonemap_row_clip;      break;
+        case TONEMAP_HABLE:    s->tonemap_row = tonemap_row_hable;     break;
+        case TONEMAP_REINHARD: s->tonemap_row = tonemap_row_reinhard;  break;
+        case TONEMAP_MOBIUS:   s->tonemap_row = tonemap_row_mobius;    break;
+        }
+    }
+
     /* do the tone map */
     td.out = out;
     td.in = in;
-    td.desc = desc;
-    td.peak = peak;
     ctx->internal->execute(ctx, tonemap_slice, &td, NULL, FFMIN(in->height, ff_filter_get_nb_threads(ctx)));
 
     /* copy/generate alpha if needed */
@@ -298,6 +411,13 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     return ff_filter_frame(outlink, out);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    TonemapContext *s = ctx->priv;
+
+    av_freep(&s->lut_data);
+}
+
 #define OFFSET(x) offsetof(TonemapContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM | AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption tonemap_options[] = {
@@ -312,6 +432,7 @@ static const AVOption tonemap_options[] = {
     { "param",        "tonemap parameter", OFFSET(param), AV_OPT_TYPE_DOUBLE, {.dbl = NAN}, DBL_MIN, DBL_MAX, FLAGS },
     { "desat",        "desaturation strength", OFFSET(desat), AV_OPT_TYPE_DOUBLE, {.dbl = 2}, 0, DBL_MAX, FLAGS },
     { "peak",         "signal peak override", OFFSET(peak), AV_OPT_TYPE_DOUBLE, {.dbl = 0}, 0, DBL_MAX, FLAGS },
+    { "lut",          "use a lookup table for the tone curve", OFFSET(lut), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, FLAGS },
     { NULL }
 };
 
@@ -338,6 +459,7 @@ AVFilter ff_vf_tonemap = {
     .name            = "tonemap",
     .description     = NULL_IF_CONFIG_SMALL("Conversion to/from different dynamic ranges."),
     .init            = init,
+    .uninit          = uninit,
     .query_formats   = query_formats,
     .priv_size       = sizeof(TonemapContext),
     .priv_class      = &tonemap_class,
@@ -45,6 +45,7 @@
 #include "libavutil/avassert.h"
 
 #define ZIMG_ALIGNMENT 32
+#define MAX_SLICES 64
 
 static const char *const var_names[] = {
     "in_w",   "iw",
@@ -76,6 +77,11 @@ enum var_name {
     VARS_NB
 };
 
+typedef struct ThreadData {
+    const AVPixFmtDescriptor *desc, *odesc;
+    AVFrame *in, *out;
+} ThreadData;
+
 typedef struct ZScaleContext {
     const AVClass *class;
 
@@ -112,13 +118,23 @@ typedef struct ZScaleContext {
 
     int force_original_aspect_ratio;
 
-    void *tmp;
-    size_t tmp_size;
+    int slices;                 ///< requested number of slices, 0 for the thread count
+    int nb_slices;              ///< number of slices the graphs are built for
+    int out_slice_start[MAX_SLICES];
+    int out_slice_end[MAX_SLICES];
+    double in_slice_start[MAX_SLICES];
+    double in_slice_end[MAX_SLICES];
+    int slice_ret[MAX_SLICES];
+    int direct;                 ///< slices of the main graph convert their own input rows only
+    int alpha_direct;           ///< slices of the alpha graph convert their own input rows only
+
+    void *tmp[MAX_SLICES];
+    size_t tmp_size[MAX_SLICES];
 
     zimg_image_format src_format, dst_format;
     zimg_image_format alpha_src_format, alpha_dst_format;
     zimg_graph_builder_params alpha_params, params;
-    zimg_filter_graph *alpha_graph, *graph;
+    zimg_filter_graph *alpha_graph[MAX_SLICES], *graph[MAX_SLICES];
 
     enum AVColorSpace in_colorspace, out_colorspace;
     enum AVColorTransferCharacteristic in_trc, out_trc;
@@ -504,6 +520,71 @@ static int graph_build(zimg_filter_graph **graph, zimg_graph_builder_params *par
     return 0;
 }
 
+/**
+ * Split the output into horizontal stripes aligned to the chroma
+ * subsampling and map each of them back to the input rows it covers.
+ */
+static void slice_params(ZScaleContext *s, int nb_slices, int out_h, int in_h, int vsub)
+{
+    const int align = 1 << vsub;
+    int i;
+
+    nb_slices = av_clip(nb_slices, 1, FFMIN(FFMAX(out_h >> vsub, 1), MAX_SLICES));
+    s->nb_slices = nb_slices;
+
+    s->out_slice_start[0] = 0;
+    for (i = 1; i < nb_slices; i++)
+        s->out_slice_end[i - 1] = s->out_slice_start[i] = out_h * i / nb_slices & ~(align - 1);
+    s->out_slice_end[nb_slices - 1] = out_h;
+
+    for (i = 0; i < nb_slices; i++) {
+        s->in_slice_start[i] = s->out_slice_start[i] * (double)in_h / out_h;
+        s->in_slice_end[i]   = s->out_slice_end[i]   * (double)in_h / out_h;
+    }
+}
+
+/**
+ * Build the graphs of every slice. When the conversion resamples the image
+ * or its chroma, zimg reads the rows around the active region of the input
+ * as needed by the resampling filter, so the slices need no explicit
+ * overlap. Otherwise each slice converts only its own rows, so that no
+ * resampling is added to a pure colorspace conversion.
+ */
+static int slice_graphs_build(ZScaleContext *s, zimg_filter_graph **graphs, int *direct,
+                              zimg_graph_builder_params *params,
+                              const zimg_image_format *src_format,
+                              const zimg_image_format *dst_format)
+{
+    int i, ret;
+
+    *direct = src_format->width            == dst_format->width            &&
+              src_format->height           == dst_format->height           &&
+              src_format->subsample_w      == dst_format->subsample_w      &&
+              src_format->subsample_h      == dst_format->subsample_h      &&
+              src_format->chroma_location  == dst_format->chroma_location;
+
+    for (i = 0; i < s->nb_slices; i++) {
+        zimg_image_format src = *src_format;
+        zimg_image_format dst = *dst_format;
+
+        dst.height = s->out_slice_end[i] - s->out_slice_start[i];
+        if (*direct) {
+            src.height = dst.height;
+        } else {
+            src.active_region.left   = 0;
+            src.active_region.top    = s->in_slice_start[i];
+            src.active_region.width  = src_format->width;
+            src.active_region.height = s->in_slice_end[i] - s->in_slice_start[i];
+        }
+
+        ret = graph_build(&graphs[i], params, &src, &dst, &s->tmp[i], &s->tmp_size[i]);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 static int realign_frame(const AVPixFmtDescriptor *desc, AVFrame **frame)
 {
     AVFrame *aligned = NULL;
@@ -542,16 +623,82 @@ fail:
     return ret;
 }
 
+static int filter_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    ZScaleContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const AVPixFmtDescriptor *desc = td->desc;
+    const AVPixFmtDescriptor *odesc = td->odesc;
+    AVFrame *in = td->in;
+    AVFrame *out = td->out;
+    const int slice_start = s->out_slice_start[jobnr];
+    const int slice_end   = s->out_slice_end[jobnr];
+    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
+    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    int ret, plane;
+
+    for (plane = 0; plane < 3; plane++) {
+        const int vsub = plane ? odesc->log2_chroma_h : 0;
+        int p = desc->comp[plane].plane;
+        src_buf.plane[plane].data   = in->data[p];
+        if (s->direct)
+            src_buf.plane[plane].data += (slice_start >> vsub) * in->linesize[p];
+        src_buf.plane[plane].stride = in->linesize[p];
+        src_buf.plane[plane].mask   = -1;
+
+        p = odesc->comp[plane].plane;
+        dst_buf.plane[plane].data   = out->data[p] + (slice_start >> vsub) * out->linesize[p];
+        dst_buf.plane[plane].stride = out->linesize[p];
+        dst_buf.plane[plane].mask   = -1;
+    }
+
+    ret = zimg_filter_graph_process(s->graph[jobnr], &src_buf, &dst_buf, s->tmp[jobnr], 0, 0, 0, 0);
+    if (ret)
+        return print_zimg_error(ctx);
+
+    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        src_buf.plane[0].data   = in->data[3];
+        if (s->alpha_direct)
+            src_buf.plane[0].data += slice_start * in->linesize[3];
+        src_buf.plane[0].stride = in->linesize[3];
+        src_buf.plane[0].mask   = -1;
+
+        dst_buf.plane[0].data   = out->data[3] + slice_start * out->linesize[3];
+        dst_buf.plane[0].stride = out->linesize[3];
+        dst_buf.plane[0].mask   = -1;
+
+        ret = zimg_filter_graph_process(s->alpha_graph[jobnr], &src_buf, &dst_buf, s->tmp[jobnr], 0, 0, 0, 0);
+        if (ret)
+            return print_zimg_error(ctx);
+    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
+        int x, y;
+
+        if (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) {
+            for (y = slice_start; y < slice_end; y++) {
+                for (x = 0; x < out->width; x++) {
+                    AV_WN32(out->data[3] + x * odesc->comp[3].step + y * out->linesize[3],
+                            av_float2int(1.0f));
+                }
+            }
+        } else {
+            for (y = slice_start; y < slice_end; y++)
+                memset(out->data[3] + y * out->linesize[3], 0xff, out->width);
+        }
+    }
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *link, AVFrame *in)
 {
-    ZScaleContext *s = link->dst->priv;
-    AVFilterLink *outlink = link->dst->outputs[0];
+    AVFilterContext *ctx = link->dst;
+    ZScaleContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const AVPixFmtDescriptor *odesc = av_pix_fmt_desc_get(outlink->format);
-    zimg_image_buffer_const src_buf = { ZIMG_API_VERSION };
-    zimg_image_buffer dst_buf = { ZIMG_API_VERSION };
+    ThreadData td;
     char buf[32];
-    int ret = 0, plane;
+    int ret = 0, i;
     AVFrame *out = NULL;
 
     if ((ret = realign_frame(desc, &in)) < 0)
@@ -566,7 +713,8 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     out->width  = outlink->w;
     out->height = outlink->h;
 
-    if(   in->width  != link->w
+    if(   !s->nb_slices
+       || in->width  != link->w
        || in->height != link->h
        || in->format != link->format
        || s->in_colorspace != in->colorspace
@@ -622,8 +770,13 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         if (s->chromal != -1)
             out->chroma_location = (int)s->dst_format.chroma_location - 1;
 
-        ret = graph_build(&s->graph, &s->params, &s->src_format, &s->dst_format,
-                          &s->tmp, &s->tmp_size);
+        /* the dither patterns and the error diffusion would restart on every slice */
+        slice_params(s, s->dither != ZIMG_DITHER_NONE ? 1 :
+                        s->slices ? s->slices : ff_filter_get_nb_threads(ctx),
+                     out->height, in->height, odesc->log2_chroma_h);
+
+        ret = slice_graphs_build(s, s->graph, &s->direct,
+                                 &s->params, &s->src_format, &s->dst_format);
         if (ret < 0)
             goto fail;
 
@@ -657,12 +810,10 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
             s->alpha_dst_format.pixel_type = (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) ? ZIMG_PIXEL_FLOAT : odesc->comp[0].depth > 8 ? ZIMG_PIXEL_WORD : ZIMG_PIXEL_BYTE;
             s->alpha_dst_format.color_family = ZIMG_COLOR_GREY;
 
-            zimg_filter_graph_free(s->alpha_graph);
-            s->alpha_graph = zimg_filter_graph_build(&s->alpha_src_format, &s->alpha_dst_format, &s->alpha_params);
-            if (!s->alpha_graph) {
-                ret = print_zimg_error(link->dst);
+            ret = slice_graphs_build(s, s->alpha_graph, &s->alpha_direct, &s->alpha_params,
+                                     &s->alpha_src_format, &s->alpha_dst_format);
+            if (ret < 0)
                 goto fail;
-            }
         }
     }
 
@@ -683,51 +834,15 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
               (int64_t)in->sample_aspect_ratio.den * outlink->w * link->h,
               INT_MAX);
 
-    for (plane = 0; plane < 3; plane++) {
-        int p = desc->comp[plane].plane;
-        src_buf.plane[plane].data   = in->data[p];
-        src_buf.plane[plane].stride = in->linesize[p];
-        src_buf.plane[plane].mask   = -1;
-
-        p = odesc->comp[plane].plane;
-        dst_buf.plane[plane].data   = out->data[p];
-        dst_buf.plane[plane].stride = out->linesize[p];
-        dst_buf.plane[plane].mask   = -1;
-    }
-
-    ret = zimg_filter_graph_process(s->graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-    if (ret) {
-        ret = print_zimg_error(link->dst);
-        goto fail;
-    }
-
-    if (desc->flags & AV_PIX_FMT_FLAG_ALPHA && odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        src_buf.plane[0].data   = in->data[3];
-        src_buf.plane[0].stride = in->linesize[3];
-        src_buf.plane[0].mask   = -1;
-
-        dst_buf.plane[0].data   = out->data[3];
-        dst_buf.plane[0].stride = out->linesize[3];
-        dst_buf.plane[0].mask   = -1;
-
-        ret = zimg_filter_graph_process(s->alpha_graph, &src_buf, &dst_buf, s->tmp, 0, 0, 0, 0);
-        if (ret) {
-            ret = print_zimg_error(link->dst);
-            goto fail;
-        }
-    } else if (odesc->flags & AV_PIX_FMT_FLAG_ALPHA) {
-        int x, y;
-
-        if (odesc->flags & AV_PIX_FMT_FLAG_FLOAT) {
-            for (y = 0; y < out->height; y++) {
-                for (x = 0; x < out->width; x++) {
-                    AV_WN32(out->data[3] + x * odesc->comp[3].step + y * out->linesize[3],
-                            av_float2int(1.0f));
-                }
-            }
-        } else {
-            for (y = 0; y < outlink->h; y++)
-                memset(out->data[3] + y * out->linesize[3], 0xff, outlink->w);
+    td.desc = desc;
+    td.odesc = odesc;
+    td.in = in;
+    td.out = out;
+    ctx->internal->execute(ctx, filter_slice, &td, s->slice_ret, s->nb_slices);
+    for (i = 0; i < s->nb_slices; i++) {
+        if (s->slice_ret[i] < 0) {
+            ret = s->slice_ret[i];
+            break;
         }
     }
 
@@ -744,11 +859,14 @@ fail:
 static av_cold void uninit(AVFilterContext *ctx)
 {
     ZScaleContext *s = ctx->priv;
+    int i;
 
-    zimg_filter_graph_free(s->graph);
-    zimg_filter_graph_free(s->alpha_graph);
-    av_freep(&s->tmp);
-    s->tmp_size = 0;
+    for (i = 0; i < MAX_SLICES; i++) {
+        zimg_filter_graph_free(s->graph[i]);
+        zimg_filter_graph_free(s->alpha_graph[i]);
+        av_freep(&s->tmp[i]);
+        s->tmp_size[i] = 0;
+    }
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
@@ -897,6 +1015,7 @@ static const AVOption zscale_options[] = {
     { "cin",        "set input chroma location", OFFSET(chromal_in), AV_OPT_TYPE_INT, {.i64 = -1}, -1, ZIMG_CHROMA_BOTTOM, FLAGS, "chroma" },
     { "npl",       "set nominal peak luminance", OFFSET(nominal_peak_luminance), AV_OPT_TYPE_DOUBLE, {.dbl = NAN}, 0, DBL_MAX, FLAGS },
     { "agamma",       "allow approximate gamma", OFFSET(approximate_gamma),      AV_OPT_TYPE_BOOL,   {.i64 = 1},   0, 1,       FLAGS },
+    { "slices",    "set number of slices, 0 for the thread count", OFFSET(slices), AV_OPT_TYPE_INT, {.i64 = 0}, 0, MAX_SLICES, FLAGS },
     { NULL }
 };
 
@@ -931,4 +1050,5 @@ AVFilter ff_vf_zscale = {
     .inputs          = avfilter_vf_zscale_inputs,
     .outputs         = avfilter_vf_zscale_outputs,
     .process_command = process_command,
+    .flags           = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -40,8 +40,13 @@
 ERROR
 #endif
 
-void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count){
-    int pos = s->dither.ns_pos;
+/**
+ * Apply noise shaping dither to the channels [ch_start, ch_end).
+ * s->dither.ns_pos is not updated, the caller must advance it by count.
+ */
+void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count,
+                                int ch_start, int ch_end){
+    int pos;
     int i, j, ch;
     int taps  = s->dither.ns_taps;
     float S   = s->dither.ns_scale;
@@ -50,7 +55,7 @@ void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData
     av_assert2((taps&3) != 2);
     av_assert2((taps&3) != 3 || s->dither.ns_coeffs[taps] == 0);
 
-    for (ch=0; ch<srcs->ch_count; ch++) {
+    for (ch=ch_start; ch<ch_end; ch++) {
         const float *noise = ((const float *)noises->ch[ch]) + s->dither.noise_pos;
         const DELEM *src = (const DELEM*)srcs->ch[ch];
         DELEM *dst = (DELEM*)dsts->ch[ch];
@@ -75,8 +80,6 @@ void RENAME(swri_noise_shaping)(SwrContext *s, AudioData *dsts, const AudioData
             dst[i] = d1;
         }
     }
-
-    s->dither.ns_pos = pos;
 }
 
 #undef RENAME
@@ -27,6 +27,7 @@
  */
 
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "resample.h"
 
 static inline double eval_poly(const double *coeff, int size, double x) {
@@ -276,11 +277,156 @@ fail:
     return ret;
 }
 
+/**
+ * Filter banks only depend on a few parameters and are never modified once
+ * built, so contexts with identical parameters share them through this
+ * process wide cache. Up to FILTER_BANK_CACHE_UNUSED banks without users are
+ * kept, so that short lived contexts created one after another do not
+ * rebuild them, the least recently released ones are freed first.
+ */
+#define FILTER_BANK_CACHE_UNUSED 4
+
+typedef struct FilterBankEntry {
+    struct FilterBankEntry *next;
+    uint8_t *filter_bank;
+    int refcount;
+
+    double factor;
+    int filter_length;
+    int phase_count;
+    enum AVSampleFormat format;
+    enum SwrFilterType filter_type;
+    double kaiser_beta;
+} FilterBankEntry;
+
+static AVMutex filter_bank_mutex = AV_MUTEX_INITIALIZER;
+static FilterBankEntry *filter_bank_cache;
+
+static FilterBankEntry *find_filter_bank(const ResampleContext *c, int phase_count)
+{
+    FilterBankEntry *e;
+
+    for (e = filter_bank_cache; e; e = e->next) {
+        if (e->factor        == c->factor        &&
+            e->filter_length == c->filter_length &&
+            e->phase_count   == phase_count      &&
+            e->format        == c->format        &&
+            e->filter_type   == c->filter_type   &&
+            e->kaiser_beta   == c->kaiser_beta)
+            return e;
+    }
+    return NULL;
+}
+
+/**
+ * Get the filter bank with phase_count phases for the filter parameters of c,
+ * building it if no other context uses it yet.
+ * The bank must be released with release_filter_bank().
+ */
+static int get_filter_bank(ResampleContext *c, int phase_count,
+                           uint8_t **filter_bank, FilterBankEntry **entry)
+{
+    FilterBankEntry *e;
+    uint8_t *bank;
+    int ret;
+
+    ff_mutex_lock(&filter_bank_mutex);
+    e = find_filter_bank(c, phase_count);
+    if (e)
+        e->refcount++;
+    ff_mutex_unlock(&filter_bank_mutex);
+    if (e)
+        goto end;
+
+    /* build outside of the lock, this can take a while */
+    bank = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
+    if (!bank)
+        return AVERROR(ENOMEM);
+    ret = build_filter(c, (void*)bank, c->factor, c->filter_length, c->filter_alloc,
+                       phase_count, 1<<c->filter_shift, c->filter_type, c->kaiser_beta);
+    if (ret < 0) {
+        av_free(bank);
+        return ret;
+    }
+    memcpy(bank + (c->filter_alloc*phase_count+1)*c->felem_size, bank, (c->filter_alloc-1)*c->felem_size);
+    memcpy(bank + (c->filter_alloc*phase_count  )*c->felem_size, bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+
+    ff_mutex_lock(&filter_bank_mutex);
+    e = find_filter_bank(c, phase_count);
+    if (e) {
+        /* another context built the same bank meanwhile */
+        e->refcount++;
+    } else if ((e = av_mallocz(sizeof(*e)))) {
+        e->filter_bank   = bank;
+        e->refcount      = 1;
+        e->factor        = c->factor;
+        e->filter_length = c->filter_length;
+        e->phase_count   = phase_count;
+        e->format        = c->format;
+        e->filter_type   = c->filter_type;
+        e->kaiser_beta   = c->kaiser_beta;
+        e->next          = filter_bank_cache;
+        filter_bank_cache = e;
+        bank = NULL;
+    }
+    ff_mutex_unlock(&filter_bank_mutex);
+    av_free(bank);
+    if (!e)
+        return AVERROR(ENOMEM);
+
+end:
+    *filter_bank = e->filter_bank;
+    *entry       = e;
+    return 0;
+}
+
+static void release_filter_bank(ResampleContext *c)
+{
+    FilterBankEntry *e = c->filter_bank_entry, **p, **last_unused = NULL;
+    int nb_unused = 0;
+
+    c->filter_bank       = NULL;
+    c->filter_bank_entry = NULL;
+    if (!e)
+        return;
+
+    ff_mutex_lock(&filter_bank_mutex);
+    if (!--e->refcount) {
+        /* move it to the front, the list is then ordered by release time */
+        for (p = &filter_bank_cache; *p != e; p = &(*p)->next)
+            ;
+        *p = e->next;
+        e->next = filter_bank_cache;
+        filter_bank_cache = e;
+
+        for (p = &filter_bank_cache; *p; p = &(*p)->next) {
+            if (!(*p)->refcount) {
+                nb_unused++;
+                last_unused = p;
+            }
+        }
+        if (nb_unused > FILTER_BANK_CACHE_UNUSED) {
+            e = *last_unused;
+            *last_unused = e->next;
+        } else {
+            e = NULL;
+        }
+    } else {
+        e = NULL;
+    }
+    ff_mutex_unlock(&filter_bank_mutex);
+
+    if (e) {
+        av_free(e->filter_bank);
+        av_free(e);
+    }
+}
+
 static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
-    av_freep(&c->filter_bank);
+    release_filter_bank(c);
     av_freep(cc);
 }
 
@@ -345,16 +491,11 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->factor        = factor;
         c->filter_length = filter_length;
         c->filter_alloc  = FFALIGN(c->filter_length, 8);
-        c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
         c->phase_count_compensation = phase_count_compensation;
-        if (!c->filter_bank)
-            goto error;
-        if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
+        if (get_filter_bank(c, phase_count, &c->filter_bank, &c->filter_bank_entry) < 0)
             goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
     }
 
     c->compensation_distance= 0;
@@ -375,7 +516,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     return c;
 error:
-    av_freep(&c->filter_bank);
+    release_filter_bank(c);
     av_free(c);
     return NULL;
 }
@@ -383,6 +524,7 @@ error:
 static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 {
     uint8_t *new_filter_bank;
+    FilterBankEntry *new_entry;
     int new_src_incr, new_dst_incr;
     int phase_count = c->phase_count_compensation;
     int ret;
@@ -392,25 +534,13 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 
     av_assert0(!c->frac && !c->dst_incr_mod);
 
-    new_filter_bank = av_calloc(c->filter_alloc, (phase_count + 1) * c->felem_size);
-    if (!new_filter_bank)
-        return AVERROR(ENOMEM);
-
-    ret = build_filter(c, new_filter_bank, c->factor, c->filter_length, c->filter_alloc,
-                       phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta);
-    if (ret < 0) {
-        av_freep(&new_filter_bank);
-        return ret;
-    }
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_alloc-1)*c->felem_size);
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, new_filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
-
     if (!av_reduce(&new_src_incr, &new_dst_incr, c->src_incr,
                    c->dst_incr * (int64_t)(phase_count/c->phase_count), INT32_MAX/2))
-    {
-        av_freep(&new_filter_bank);
         return AVERROR(EINVAL);
-    }
+
+    ret = get_filter_bank(c, phase_count, &new_filter_bank, &new_entry);
+    if (ret < 0)
+        return ret;
 
     c->src_incr = new_src_incr;
     c->dst_incr = new_dst_incr;
@@ -423,8 +553,9 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
     c->dst_incr_mod   = c->dst_incr % c->src_incr;
     c->index         *= phase_count / c->phase_count;
     c->phase_count    = phase_count;
-    av_freep(&c->filter_bank);
-    c->filter_bank = new_filter_bank;
+    release_filter_bank(c);
+    c->filter_bank       = new_filter_bank;
+    c->filter_bank_entry = new_entry;
     return 0;
 }
 
@@ -449,7 +580,68 @@ static int set_compensation(ResampleContext *c, int sample_delta, int compensati
     return 0;
 }
 
-static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed){
+typedef struct ResampleThreadData {
+    ResampleContext *c;
+    AudioData *dst, *src;
+    int n;
+    int (*resample_func)(struct ResampleContext *c, void *dst,
+                         const void *src, int n, int update_ctx);
+    int need_emms;
+} ResampleThreadData;
+
+static void resample_channels(SwrContext *s, void *arg, int jobnr, int nb_jobs)
+{
+    ResampleThreadData *td = arg;
+    int ch_start = (td->dst->ch_count *  jobnr   ) / nb_jobs;
+    int ch_end   = (td->dst->ch_count * (jobnr+1)) / nb_jobs;
+    int ch;
+
+    for (ch = ch_start; ch < ch_end; ch++)
+        td->resample_func(td->c, td->dst->ch[ch], td->src->ch[ch], td->n, 0);
+
+    /* the MMX state is per thread */
+    if (td->need_emms)
+        emms_c();
+}
+
+/**
+ * Advance the filter position by n output samples, as resample_common()
+ * and resample_linear() do when called with update_ctx set.
+ *
+ * @return the number of consumed input samples
+ */
+static int advance_position(ResampleContext *c, int n)
+{
+    int index = c->index;
+    int frac  = c->frac;
+    int sample_index = 0;
+
+    while (index >= c->phase_count) {
+        sample_index++;
+        index -= c->phase_count;
+    }
+
+    while (n--) {
+        frac  += c->dst_incr_mod;
+        index += c->dst_incr_div;
+        if (frac >= c->src_incr) {
+            frac -= c->src_incr;
+            index++;
+        }
+
+        while (index >= c->phase_count) {
+            sample_index++;
+            index -= c->phase_count;
+        }
+    }
+
+    c->frac  = frac;
+    c->index = index;
+    return sample_index;
+}
+
+static int multiple_resample(SwrContext *s, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed){
+    ResampleContext *c = s->resample;
     int i;
     int av_unused mm_flags = av_get_cpu_flags();
     int need_emms = c->format == AV_SAMPLE_FMT_S16P && ARCH_X86_32 &&
@@ -494,8 +686,17 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (s->slicethread && dst->ch_count > 1) {
+                ResampleThreadData td = { c, dst, src, dst_size, resample_func, need_emms };
+
+                /* the channels only read the position, it is updated once
+                 * all of them are done */
+                swri_execute(s, resample_channels, &td, dst->ch_count);
+                *consumed = advance_position(c, dst_size);
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
@@ -129,11 +129,29 @@ static void clear_context(SwrContext *s){
     swri_audio_convert_free(&s->out_convert);
     swri_audio_convert_free(&s->full_convert);
     swri_rematrix_free(s);
+    avpriv_slicethread_free(&s->slicethread);
 
     s->delayed_samples_fixup = 0;
     s->flushed = 0;
 }
 
+static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    SwrContext *s = priv;
+    s->execute_func(s, s->execute_arg, jobnr, nb_jobs);
+}
+
+void swri_execute(SwrContext *s, swri_job_func *func, void *arg, int nb_jobs)
+{
+    if (!s->slicethread || nb_jobs <= 1) {
+        func(s, arg, 0, 1);
+        return;
+    }
+    s->execute_func = func;
+    s->execute_arg  = arg;
+    avpriv_slicethread_execute(s->slicethread, nb_jobs, 0);
+}
+
 av_cold void swr_free(SwrContext **ss){
     SwrContext *s= *ss;
     if(s){
@@ -390,6 +408,12 @@ av_assert0(s->out.ch_count);
             goto fail;
     }
 
+    if (s->nb_threads != 1 && FFMAX(s->used_ch_count, s->out.ch_count) > 1) {
+        ret = avpriv_slicethread_create(&s->slicethread, s, worker_func, NULL, s->nb_threads);
+        if (ret <= 1)
+            avpriv_slicethread_free(&s->slicethread);
+    }
+
     return 0;
 fail:
     swr_close(s);
@@ -514,7 +538,7 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
         int ret, size, consumed;
         if(!s->resample_in_constraint && s->in_buffer_count){
             buf_set(&tmp, &s->in_buffer, s->in_buffer_index);
-            ret= s->resampler->multiple_resample(s->resample, &out, out_count, &tmp, s->in_buffer_count, &consumed);
+            ret= s->resampler->multiple_resample(s, &out, out_count, &tmp, s->in_buffer_count, &consumed);
             out_count -= ret;
             ret_sum += ret;
             buf_set(&out, &out, ret);
@@ -534,7 +558,7 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
 
         if((s->flushed || in_count > padless) && !s->in_buffer_count){
             s->in_buffer_index=0;
-            ret= s->resampler->multiple_resample(s->resample, &out, out_count, &in, FFMAX(in_count-padless, 0), &consumed);
+            ret= s->resampler->multiple_resample(s, &out, out_count, &in, FFMAX(in_count-padless, 0), &consumed);
             out_count -= ret;
             ret_sum += ret;
             buf_set(&out, &out, ret);
@@ -579,6 +603,45 @@ static int resample(SwrContext *s, AudioData *out_param, int out_count,
     return ret_sum;
 }
 
+typedef struct DitherThreadData {
+    AudioData *dst, *src;
+    int count;
+} DitherThreadData;
+
+static void dither_channels(SwrContext *s, void *arg, int jobnr, int nb_jobs){
+    DitherThreadData *td = arg;
+    AudioData *conv_src = td->dst;
+    AudioData *preout   = td->src;
+    int out_count = td->count;
+    int ch_start = (preout->ch_count *  jobnr   ) / nb_jobs;
+    int ch_end   = (preout->ch_count * (jobnr+1)) / nb_jobs;
+    int ch;
+
+    if (s->dither.method < SWR_DITHER_NS){
+        if (s->mix_2_1_simd) {
+            int len1= out_count&~15;
+            int off = len1 * preout->bps;
+
+            if(len1)
+                for(ch=ch_start; ch<ch_end; ch++)
+                    s->mix_2_1_simd(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_simd_one, 0, 0, len1);
+            if(out_count != len1)
+                for(ch=ch_start; ch<ch_end; ch++)
+                    s->mix_2_1_f(conv_src->ch[ch] + off, preout->ch[ch] + off, s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos + off, s->native_one, 0, 0, out_count - len1);
+        } else {
+            for(ch=ch_start; ch<ch_end; ch++)
+                s->mix_2_1_f(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_one, 0, 0, out_count);
+        }
+    } else {
+        switch(s->int_sample_fmt) {
+        case AV_SAMPLE_FMT_S16P :swri_noise_shaping_int16(s, conv_src, preout, &s->dither.noise, out_count, ch_start, ch_end); break;
+        case AV_SAMPLE_FMT_S32P :swri_noise_shaping_int32(s, conv_src, preout, &s->dither.noise, out_count, ch_start, ch_end); break;
+        case AV_SAMPLE_FMT_FLTP :swri_noise_shaping_float(s, conv_src, preout, &s->dither.noise, out_count, ch_start, ch_end); break;
+        case AV_SAMPLE_FMT_DBLP :swri_noise_shaping_double(s,conv_src, preout, &s->dither.noise, out_count, ch_start, ch_end); break;
+        }
+    }
+}
+
 static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_count,
                                                       AudioData *in , int  in_count){
     AudioData *postin, *midbuf, *preout;
@@ -656,6 +719,7 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
     if(preout != out && out_count){
         AudioData *conv_src = preout;
         if(s->dither.method){
+            DitherThreadData td;
             int ch;
             int dither_count= FFMAX(out_count, 1<<16);
 
@@ -676,28 +740,13 @@ static int swr_convert_internal(struct SwrContext *s, AudioData *out, int out_co
             if(s->dither.noise_pos + out_count > s->dither.noise.count)
                 s->dither.noise_pos = 0;
 
-            if (s->dither.method < SWR_DITHER_NS){
-                if (s->mix_2_1_simd) {
-                    int len1= out_count&~15;
-                    int off = len1 * preout->bps;
-
-                    if(len1)
-                        for(ch=0; ch<preout->ch_count; ch++)
-                            s->mix_2_1_simd(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_simd_one, 0, 0, len1);
-                    if(out_count != len1)
-                        for(ch=0; ch<preout->ch_count; ch++)
-                            s->mix_2_1_f(conv_src->ch[ch] + off, preout->ch[ch] + off, s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos + off, s->native_one, 0, 0, out_count - len1);
-                } else {
-                    for(ch=0; ch<preout->ch_count; ch++)
-                        s->mix_2_1_f(conv_src->ch[ch], preout->ch[ch], s->dither.noise.ch[ch] + s->dither.noise.bps * s->dither.noise_pos, s->native_one, 0, 0, out_count);
-                }
-            } else {
-                switch(s->int_sample_fmt) {
-                case AV_SAMPLE_FMT_S16P :swri_noise_shaping_int16(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_S32P :swri_noise_shaping_int32(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_FLTP :swri_noise_shaping_float(s, conv_src, preout, &s->dither.noise, out_count); break;
-                case AV_SAMPLE_FMT_DBLP :swri_noise_shaping_double(s,conv_src, preout, &s->dither.noise, out_count); break;
-                }
+            td.dst   = conv_src;
+            td.src   = preout;
+            td.count = out_count;
+            swri_execute(s, dither_channels, &td, preout->ch_count);
+            if (s->dither.method >= SWR_DITHER_NS) {
+                int taps = s->dither.ns_taps;
+                s->dither.ns_pos = ((s->dither.ns_pos - out_count) % taps + taps) % taps;
             }
             s->dither.noise_pos += out_count;
         }
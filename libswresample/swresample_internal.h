@@ -23,6 +23,7 @@
 
 #include "swresample.h"
 #include "libavutil/channel_layout.h"
+#include "libavutil/slicethread.h"
 #include "config.h"
 
 #define SWR_CH_MAX 64
@@ -71,7 +72,7 @@ struct DitherContext {
 typedef struct ResampleContext * (* resample_init_func)(struct ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta, double precision, int cheby, int exact_rational);
 typedef void    (* resample_free_func)(struct ResampleContext **c);
-typedef int     (* multiple_resample_func)(struct ResampleContext *c, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed);
+typedef int     (* multiple_resample_func)(struct SwrContext *s, AudioData *dst, int dst_size, AudioData *src, int src_size, int *consumed);
 typedef int     (* resample_flush_func)(struct SwrContext *c);
 typedef int     (* set_compensation_func)(struct ResampleContext *c, int sample_delta, int compensation_distance);
 typedef int64_t (* get_delay_func)(struct SwrContext *s, int64_t base);
@@ -92,6 +93,11 @@ struct Resampler {
 extern struct Resampler const swri_resampler;
 extern struct Resampler const swri_soxr_resampler;
 
+/**
+ * Function run by swri_execute(), processing the part jobnr of nb_jobs.
+ */
+typedef void (swri_job_func)(struct SwrContext *s, void *arg, int jobnr, int nb_jobs);
+
 struct SwrContext {
     const AVClass *av_class;                        ///< AVClass used for AVOption and av_log()
     int log_level_offset;                           ///< logging level offset
@@ -139,6 +145,7 @@ struct SwrContext {
     float soft_compensation_duration;               ///< swr duration over which soft compensation is applied
     float max_soft_compensation;                    ///< swr maximum soft compensation in seconds over soft_compensation_duration
     float async;                                    ///< swr simple 1 parameter async, similar to ffmpegs -async
+    int nb_threads;                                 ///< number of threads used to process channels in parallel, 0 for automatic
     int64_t firstpts_in_samples;                    ///< swr first pts in samples
 
     int resample_first;                             ///< 1 if resampling must come first, 0 if rematrixing
@@ -184,16 +191,26 @@ struct SwrContext {
 
     mix_any_func_type *mix_any_f;
 
+    AVSliceThread *slicethread;                     ///< thread pool, NULL if channels are processed serially
+    swri_job_func *execute_func;                    ///< job currently run by the thread pool
+    void *execute_arg;                              ///< argument of execute_func
+
     /* TODO: callbacks for ASM optimizations */
 };
 
 av_warn_unused_result
 int swri_realloc_audio(AudioData *a, int count);
 
-void swri_noise_shaping_int16 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_int32 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_float (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
-void swri_noise_shaping_double(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count);
+/**
+ * Run func for nb_jobs jobs, in parallel if a thread pool is available.
+ * Without one, func is called once with jobnr 0 and nb_jobs 1.
+ */
+void swri_execute(SwrContext *s, swri_job_func *func, void *arg, int nb_jobs);
+
+void swri_noise_shaping_int16 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+void swri_noise_shaping_int32 (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+void swri_noise_shaping_float (SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
+void swri_noise_shaping_double(SwrContext *s, AudioData *dsts, const AudioData *srcs, const AudioData *noises, int count, int ch_start, int ch_end);
 
 av_warn_unused_result
 int swri_rematrix_init(SwrContext *s);
@@ -181,6 +181,9 @@ static const struct {
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
 #endif
+#if CONFIG_SWRESAMPLE
+    { "swr_resample", checkasm_check_swr_resample },
+#endif
 #if CONFIG_SWSCALE
     { "sw_rgb", checkasm_check_sw_rgb },
 #endif
@@ -438,6 +438,98 @@ static void check_loop_filter_intra(void)
     }
 }
 
+static void check_weight(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, buf, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [16 * 16 * 2]);
+    H264DSPContext h;
+    int bit_depth, i, j, k;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *dst, ptrdiff_t stride,
+                      int height, int log2_denom, int weight, int offset);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        uint32_t mask = pixel_mask[bit_depth - 8];
+        ptrdiff_t stride = 16 * SIZEOF_PIXEL;
+        ff_h264dsp_init(&h, bit_depth, 1);
+        for (i = 0; i < 3; i++) {
+            int width = 16 >> i;
+            if (check_func(h.weight_h264_pixels_tab[i], "h264_weight_%d_%dbpp", width, bit_depth)) {
+                for (j = 0; j < 2; j++) {
+                    int height     = width >> j;
+                    int log2_denom = rnd() % 8;
+                    int weight     = (int)(rnd() % 256) - 128;
+                    int offset     = (int)(rnd() % 256) - 128;
+                    for (k = 0; k < 16 * 16 * 2; k += 4)
+                        AV_WN32A(buf + k, rnd() & mask);
+                    memcpy(dst0, buf, 16 * 16 * 2);
+                    memcpy(dst1, buf, 16 * 16 * 2);
+                    call_ref(dst0, stride, height, log2_denom, weight, offset);
+                    call_new(dst1, stride, height, log2_denom, weight, offset);
+                    if (memcmp(dst0, dst1, 16 * 16 * 2)) {
+                        fprintf(stderr, "weight_%d: height:%d log2_denom:%d "
+                                "weight:%d offset:%d\n", width, height,
+                                log2_denom, weight, offset);
+                        fail();
+                    }
+                    bench_new(dst1, stride, height, log2_denom, weight, offset);
+                }
+            }
+        }
+    }
+}
+
+static void check_biweight(void)
+{
+    LOCAL_ALIGNED_16(uint8_t, src, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, buf, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [16 * 16 * 2]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [16 * 16 * 2]);
+    H264DSPContext h;
+    int bit_depth, i, j, k;
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *dst, uint8_t *src,
+                      ptrdiff_t stride, int height, int log2_denom,
+                      int weightd, int weights, int offset);
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        uint32_t mask = pixel_mask[bit_depth - 8];
+        ptrdiff_t stride = 16 * SIZEOF_PIXEL;
+        ff_h264dsp_init(&h, bit_depth, 1);
+        for (i = 0; i < 3; i++) {
+            int width = 16 >> i;
+            if (check_func(h.biweight_h264_pixels_tab[i], "h264_biweight_%d_%dbpp", width, bit_depth)) {
+                for (j = 0; j < 2; j++) {
+                    /* The 8-bit SIMD versions accumulate in saturating
+                     * 16-bit words, so keep the weights in a range where
+                     * that cannot overflow. */
+                    int height     = width >> j;
+                    int log2_denom = rnd() % 8;
+                    int weightd    = (int)(rnd() % 64) - 32;
+                    int weights    = (int)(rnd() % 64) - 32;
+                    int offset     = (int)(rnd() % 256) - 128;
+                    for (k = 0; k < 16 * 16 * 2; k += 4) {
+                        AV_WN32A(buf + k, rnd() & mask);
+                        AV_WN32A(src + k, rnd() & mask);
+                    }
+                    memcpy(dst0, buf, 16 * 16 * 2);
+                    memcpy(dst1, buf, 16 * 16 * 2);
+                    call_ref(dst0, src, stride, height, log2_denom, weightd, weights, offset);
+                    call_new(dst1, src, stride, height, log2_denom, weightd, weights, offset);
+                    if (memcmp(dst0, dst1, 16 * 16 * 2)) {
+                        fprintf(stderr, "biweight_%d: height:%d log2_denom:%d "
+                                "weightd:%d weights:%d offset:%d\n", width,
+                                height, log2_denom, weightd, weights, offset);
+                        fail();
+                    }
+                    bench_new(dst1, src, stride, height, log2_denom, weightd, weights, offset);
+                }
+            }
+        }
+    }
+}
+
 void checkasm_check_h264dsp(void)
 {
     check_idct();
@@ -449,4 +541,10 @@ void checkasm_check_h264dsp(void)
 
     check_loop_filter_intra();
     report("loop_filter_intra");
+
+    check_weight();
+    report("weight");
+
+    check_biweight();
+    report("biweight");
 }
@@ -0,0 +1,192 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+#include "libavutil/samplefmt.h"
+
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define PHASE_COUNT 32
+#define MAX_FILTER  64
+#define DST_LEN     256
+/* 44100 -> 48000 needs at most DST_LEN * 147 / 160 input samples plus the filter taps */
+#define SRC_LEN     (DST_LEN + MAX_FILTER + 16)
+
+static const int filter_lengths[] = { 8, 16, 22, 32, 64 };
+
+static void init_context(ResampleContext *c, enum AVSampleFormat format,
+                         uint8_t *filter_bank, int filter_length)
+{
+    memset(c, 0, sizeof(*c));
+    c->format        = format;
+    c->felem_size    = av_get_bytes_per_sample(format);
+    c->filter_shift  = format == AV_SAMPLE_FMT_S16P ? 15 :
+                       format == AV_SAMPLE_FMT_S32P ? 30 : 0;
+    c->filter_bank   = filter_bank;
+    c->filter_length = filter_length;
+    c->filter_alloc  = FFALIGN(filter_length, 8);
+    c->phase_count   = PHASE_COUNT;
+    /* 44100 -> 48000 */
+    c->src_incr      = 160;
+    c->dst_incr      = 147 * PHASE_COUNT;
+    c->ideal_dst_incr = c->dst_incr;
+    c->dst_incr_div  = c->dst_incr / c->src_incr;
+    c->dst_incr_mod  = c->dst_incr % c->src_incr;
+    c->index         = rnd() % (2 * PHASE_COUNT);
+    c->frac          = rnd() % c->src_incr;
+    swri_resample_dsp_init(c);
+}
+
+/* Fill the filter bank and input with values which cannot overflow the
+ * accumulators of the integer implementations. */
+static void randomize(enum AVSampleFormat format, uint8_t *filter_bank,
+                      uint8_t *src, int filter_length)
+{
+    int n = FFALIGN(filter_length, 8) * (PHASE_COUNT + 1);
+    int i;
+
+    for (i = 0; i < n; i++) {
+        switch (format) {
+        case AV_SAMPLE_FMT_S16P:
+            ((int16_t *)filter_bank)[i] = (int)(rnd() % (2 * 32768 / MAX_FILTER)) - 32768 / MAX_FILTER;
+            break;
+        case AV_SAMPLE_FMT_S32P:
+            ((int32_t *)filter_bank)[i] = (int)(rnd() % (2U * (1U << 30) / MAX_FILTER)) - (1 << 30) / MAX_FILTER;
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            ((float *)filter_bank)[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / (float)(0x8000 * MAX_FILTER);
+            break;
+        case AV_SAMPLE_FMT_DBLP:
+            ((double *)filter_bank)[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / (double)(0x8000 * MAX_FILTER);
+            break;
+        }
+    }
+    for (i = 0; i < SRC_LEN; i++) {
+        switch (format) {
+        case AV_SAMPLE_FMT_S16P: ((int16_t *)src)[i] = rnd();                                break;
+        case AV_SAMPLE_FMT_S32P: ((int32_t *)src)[i] = rnd();                                break;
+        case AV_SAMPLE_FMT_FLTP: ((float   *)src)[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / 32768.0f; break;
+        case AV_SAMPLE_FMT_DBLP: ((double  *)src)[i] = ((int)(rnd() & 0xFFFF) - 0x8000) / 32768.0;  break;
+        }
+    }
+}
+
+static int compare(enum AVSampleFormat format, const uint8_t *ref, const uint8_t *new,
+                   int n, int linear)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        switch (format) {
+        case AV_SAMPLE_FMT_S16P: {
+            int a = ((const int16_t *)ref)[i], b = ((const int16_t *)new)[i];
+            /* the interpolation between phases may round differently */
+            if (FFABS(a - b) > linear) {
+                fprintf(stderr, "%d: %d != %d\n", i, a, b);
+                return 1;
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_S32P: {
+            int64_t a = ((const int32_t *)ref)[i], b = ((const int32_t *)new)[i];
+            if (FFABS(a - b) > linear) {
+                fprintf(stderr, "%d: %"PRId64" != %"PRId64"\n", i, a, b);
+                return 1;
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_FLTP: {
+            float a = ((const float *)ref)[i], b = ((const float *)new)[i];
+            if (!float_near_abs_eps(a, b, MAX_FILTER * 2 * FLT_EPSILON)) {
+                fprintf(stderr, "%d: %- .12f - %- .12f = % .12g\n", i, a, b, a - b);
+                return 1;
+            }
+            break;
+        }
+        case AV_SAMPLE_FMT_DBLP: {
+            double a = ((const double *)ref)[i], b = ((const double *)new)[i];
+            if (!double_near_abs_eps(a, b, MAX_FILTER * 2 * DBL_EPSILON)) {
+                fprintf(stderr, "%d: %- .12f - %- .12f = % .12g\n", i, a, b, a - b);
+                return 1;
+            }
+            break;
+        }
+        }
+    }
+    return 0;
+}
+
+static void check_resample(enum AVSampleFormat format, int linear)
+{
+    LOCAL_ALIGNED_32(uint8_t, filter_bank, [FFALIGN(MAX_FILTER, 8) * (PHASE_COUNT + 1) * 8]);
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_LEN * 8]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_LEN * 8]);
+    ResampleContext c0, c1;
+    const char *name = av_get_sample_fmt_name(format);
+    int i;
+
+    declare_func_emms(AV_CPU_FLAG_MMXEXT, int, ResampleContext *c, void *dst, const void *src,
+                      int n, int update_ctx);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(filter_lengths); i++) {
+        int filter_length = filter_lengths[i];
+        void *func;
+
+        randomize(format, filter_bank, src, filter_length);
+        init_context(&c0, format, filter_bank, filter_length);
+        c1 = c0;
+
+        func = linear ? c0.dsp.resample_linear : c0.dsp.resample_common;
+        if (check_func(func, "resample_%s_%s_%d", linear ? "linear" : "common",
+                       name, filter_length)) {
+            int ret0, ret1;
+
+            memset(dst0, 0, DST_LEN * 8);
+            memset(dst1, 0, DST_LEN * 8);
+            ret0 = call_ref(&c0, dst0, src, DST_LEN, 1);
+            ret1 = call_new(&c1, dst1, src, DST_LEN, 1);
+            if (ret0 != ret1 || c0.index != c1.index || c0.frac != c1.frac ||
+                compare(format, dst0, dst1, DST_LEN, linear))
+                fail();
+            bench_new(&c1, dst1, src, DST_LEN, 0);
+        }
+    }
+}
+
+void checkasm_check_swr_resample(void)
+{
+    static const enum AVSampleFormat formats[] = {
+        AV_SAMPLE_FMT_S16P, AV_SAMPLE_FMT_S32P, AV_SAMPLE_FMT_FLTP, AV_SAMPLE_FMT_DBLP,
+    };
+    int i;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        check_resample(formats[i], 0);
+    report("resample_common");
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++)
+        check_resample(formats[i], 1);
+    report("resample_linear");
+}
@@ -21,11 +21,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include "libavutil/lfg.h"
 #include "libavfilter/dnn/dnn_backend_native_layer_conv2d.h"
 
 #define EPSON 0.00001
 
-static int test_with_same_dilate(void)
+static int test_with_same_dilate(NativeContext *ctx)
 {
     // the input data and expected data are generated with below python code.
     /*
@@ -114,7 +115,7 @@ static int test_with_same_dilate(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
-    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params);
+    dnn_execute_layer_conv2d(ctx, operands, input_indexes, 1, &params);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -129,7 +130,7 @@ static int test_with_same_dilate(void)
     return 0;
 }
 
-static int test_with_valid(void)
+static int test_with_valid(NativeContext *ctx)
 {
     // the input data and expected data are generated with below python code.
     /*
@@ -214,7 +215,7 @@ static int test_with_valid(void)
     operands[1].data = NULL;
 
     input_indexes[0] = 0;
-    dnn_execute_layer_conv2d(operands, input_indexes, 1, &params);
+    dnn_execute_layer_conv2d(ctx, operands, input_indexes, 1, &params);
 
     output = operands[1].data;
     for (int i = 0; i < sizeof(expected_output) / sizeof(float); i++) {
@@ -229,12 +230,143 @@ static int test_with_valid(void)
     return 0;
 }
 
-int main(int argc, char **argv)
+static void conv2d_ref(const ConvolutionalParams *params, const float *input,
+                       int height, int width, float *output)
+{
+    int radius = params->kernel_size >> 1;
+    int src_linesize = width * params->input_num;
+    int filter_linesize = params->kernel_size * params->input_num;
+    int filter_size = params->kernel_size * filter_linesize;
+    int pad_size = (params->padding_method == VALID) ? (params->kernel_size - 1) / 2 * params->dilation : 0;
+
+    for (int y = pad_size; y < height - pad_size; ++y) {
+        for (int x = pad_size; x < width - pad_size; ++x) {
+            for (int n_filter = 0; n_filter < params->output_num; ++n_filter) {
+                double sum = params->has_bias ? params->biases[n_filter] : 0.0;
+                for (int ch = 0; ch < params->input_num; ++ch) {
+                    for (int kernel_y = 0; kernel_y < params->kernel_size; ++kernel_y) {
+                        for (int kernel_x = 0; kernel_x < params->kernel_size; ++kernel_x) {
+                            int y_pos = y + (kernel_y - radius) * params->dilation;
+                            int x_pos = x + (kernel_x - radius) * params->dilation;
+                            float input_pel;
+                            if (params->padding_method == SAME_CLAMP_TO_EDGE) {
+                                y_pos = av_clip(y_pos, 0, height - 1);
+                                x_pos = av_clip(x_pos, 0, width - 1);
+                                input_pel = input[y_pos * src_linesize + x_pos * params->input_num + ch];
+                            } else {
+                                input_pel = (x_pos < 0 || x_pos >= width || y_pos < 0 || y_pos >= height) ? 0.0 :
+                                            input[y_pos * src_linesize + x_pos * params->input_num + ch];
+                            }
+                            sum += input_pel * params->kernel[n_filter * filter_size + kernel_y * filter_linesize +
+                                                              kernel_x * params->input_num + ch];
+                        }
+                    }
+                }
+                *output++ = sum;
+            }
+        }
+    }
+}
+
+static int test_with_random(NativeContext *ctx, DNNConvPaddingParam padding_method,
+                            int kernel_size, int dilation)
+{
+    ConvolutionalParams params;
+    DnnOperand operands[2];
+    int32_t input_indexes[1];
+    int height = 23, width = 37;
+    float input[23 * 37 * 5];
+    float kernel[7 * 5 * 5 * 5];
+    float bias[7];
+    float *expected_output, *output;
+    int pad_size, length, ret = 0;
+    AVLFG lfg;
+
+    av_lfg_init(&lfg, 0xd4a1);
+    for (int i = 0; i < FF_ARRAY_ELEMS(input); i++)
+        input[i] = av_lfg_get(&lfg) / (float)UINT32_MAX;
+    for (int i = 0; i < FF_ARRAY_ELEMS(kernel); i++)
+        kernel[i] = av_lfg_get(&lfg) / (float)UINT32_MAX - 0.5f;
+    for (int i = 0; i < FF_ARRAY_ELEMS(bias); i++)
+        bias[i] = av_lfg_get(&lfg) / (float)UINT32_MAX - 0.5f;
+
+    params.activation = NONE;
+    params.has_bias = 1;
+    params.biases = bias;
+    params.dilation = dilation;
+    params.input_num = 5;
+    params.kernel = kernel;
+    params.kernel_size = kernel_size;
+    params.output_num = 7;
+    params.padding_method = padding_method;
+
+    operands[0].data = input;
+    operands[0].dims[0] = 1;
+    operands[0].dims[1] = height;
+    operands[0].dims[2] = width;
+    operands[0].dims[3] = 5;
+    operands[1].data = NULL;
+
+    pad_size = (padding_method == VALID) ? (kernel_size - 1) / 2 * dilation : 0;
+    length = (height - 2 * pad_size) * (width - 2 * pad_size) * params.output_num;
+    expected_output = av_malloc_array(length, sizeof(*expected_output));
+    if (!expected_output)
+        return 1;
+    conv2d_ref(&params, input, height, width, expected_output);
+
+    input_indexes[0] = 0;
+    dnn_execute_layer_conv2d(ctx, operands, input_indexes, 1, &params);
+
+    output = operands[1].data;
+    for (int i = 0; i < length; i++) {
+        if (fabs(output[i] - expected_output[i]) > EPSON * 10) {
+            printf("padding %d, kernel %d, dilation %d, at index %d, output: %f, expected_output: %f\n",
+                   padding_method, kernel_size, dilation, i, output[i], expected_output[i]);
+            ret = 1;
+            break;
+        }
+    }
+
+    av_freep(&output);
+    av_freep(&expected_output);
+    return ret;
+}
+
+static int test_all(NativeContext *ctx)
 {
-    if (test_with_valid())
+    if (test_with_valid(ctx))
         return 1;
-    if (test_with_same_dilate())
+    if (test_with_same_dilate(ctx))
         return 1;
 
+    for (int padding = VALID; padding <= SAME_CLAMP_TO_EDGE; padding++) {
+        if (test_with_random(ctx, padding, 3, 1))
+            return 1;
+        if (test_with_random(ctx, padding, 3, 2))
+            return 1;
+        if (test_with_random(ctx, padding, 5, 1))
+            return 1;
+    }
+
     return 0;
 }
+
+int main(int argc, char **argv)
+{
+    NativeContext ctx = { 0 };
+    int ret;
+
+    if (dnn_native_init_context(&ctx, 1) < 0)
+        return 1;
+    ret = test_all(&ctx);
+    dnn_native_uninit_context(&ctx);
+    if (ret)
+        return ret;
+
+    if (dnn_native_init_context(&ctx, 3) < 0)
+        return 1;
+    ret = test_all(&ctx);
+    dnn_native_uninit_context(&ctx);
+
+    return ret;
+}
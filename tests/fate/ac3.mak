@@ -82,8 +82,21 @@ fate-eac3-encode: CMP_SHIFT = -1024
 fate-eac3-encode: CMP_TARGET = 516.94
 fate-eac3-encode: SIZE_TOLERANCE = 488
 
-fate-ac3-encode fate-eac3-encode: CMP = stddev
-fate-ac3-encode fate-eac3-encode: REF = $(SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav
+FATE_AC3-$(call ENCDEC, AC3, AC3) += fate-ac3-encode-threads
+fate-ac3-encode-threads: CMD = enc_dec_pcm ac3 wav s16le $(subst $(SAMPLES),$(TARGET_SAMPLES),$(REF)) -c:a ac3 -b:a 128k -threads 4 -thread_type slice
+fate-ac3-encode-threads: CMP_SHIFT = -1024
+fate-ac3-encode-threads: CMP_TARGET = 404.53
+fate-ac3-encode-threads: SIZE_TOLERANCE = 488
+
+FATE_EAC3-$(call ENCDEC, EAC3, EAC3) += fate-eac3-encode-threads
+fate-eac3-encode-threads: CMD = enc_dec_pcm eac3 wav s16le $(subst $(SAMPLES),$(TARGET_SAMPLES),$(REF)) -c:a eac3 -b:a 128k -threads 4 -thread_type slice
+fate-eac3-encode-threads: CMP_SHIFT = -1024
+fate-eac3-encode-threads: CMP_TARGET = 516.94
+fate-eac3-encode-threads: SIZE_TOLERANCE = 488
+
+FATE_AC3_ENCODE = fate-ac3-encode fate-eac3-encode fate-ac3-encode-threads fate-eac3-encode-threads
+$(FATE_AC3_ENCODE): CMP = stddev
+$(FATE_AC3_ENCODE): REF = $(SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav
 
 FATE_AC3-$(call ENCMUX, AC3_FIXED, AC3) += fate-ac3-fixed-encode
 fate-ac3-fixed-encode: tests/data/asynth-44100-2.wav
@@ -92,6 +105,13 @@ fate-ac3-fixed-encode: CMD = md5 -i $(SRC) -c ac3_fixed -ab 128k -f ac3 -flags +
 fate-ac3-fixed-encode: CMP = oneline
 fate-ac3-fixed-encode: REF = a1d1fc116463b771abf5aef7ed37d7b1
 
+FATE_AC3-$(call ENCMUX, AC3_FIXED, AC3) += fate-ac3-fixed-encode-threads
+fate-ac3-fixed-encode-threads: tests/data/asynth-44100-2.wav
+fate-ac3-fixed-encode-threads: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+fate-ac3-fixed-encode-threads: CMD = md5 -i $(SRC) -c ac3_fixed -ab 128k -threads 4 -thread_type slice -f ac3 -flags +bitexact
+fate-ac3-fixed-encode-threads: CMP = oneline
+fate-ac3-fixed-encode-threads: REF = a1d1fc116463b771abf5aef7ed37d7b1
+
 FATE_EAC3-$(call ALLYES, EAC3_DEMUXER EAC3_MUXER EAC3_CORE_BSF) += fate-eac3-core-bsf
 fate-eac3-core-bsf: CMD = md5pipe -i $(TARGET_SAMPLES)/eac3/the_great_wall_7.1.eac3 -c:a copy -bsf:a eac3_core -fflags +bitexact -f eac3
 fate-eac3-core-bsf: CMP = oneline
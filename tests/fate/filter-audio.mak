@@ -128,6 +128,26 @@ fate-filter-firequalizer: CMP = oneoff
 fate-filter-firequalizer: CMP_UNIT = s16
 fate-filter-firequalizer: SIZE_TOLERANCE = 1058400 - 1097208
 
+# the frequency domain convolution must match the time domain one,
+# with and without the channels split across threads
+HEADPHONE_HRIR = aevalsrc=exp(-t*3000)*sin(2*PI*1000*t)|exp(-t*2000)*sin(2*PI*1500*t)|exp(-t*2500)*sin(2*PI*700*t)|exp(-t*1000)*sin(2*PI*2000*t):c=quad:s=44100:d=0.01
+HEADPHONE_ARGS = -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav \
+        -filter_complex "$(HEADPHONE_HRIR)[hrir];[0:a][hrir]headphone=map=FL|FR:hrir=multich:type=$(1)" -f f32le
+
+tests/data/headphone-time.f32: TAG = GEN
+tests/data/headphone-time.f32: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/asynth-44100-2.wav | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -filter_complex_threads 1 $(call HEADPHONE_ARGS,time) \
+        -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_HEADPHONE = fate-filter-headphone-freq-1 fate-filter-headphone-freq-3
+FATE_AFILTER-$(call ALLYES, AEVALSRC_FILTER HEADPHONE_FILTER WAV_DEMUXER PCM_S16LE_DECODER PCM_F32LE_ENCODER PCM_F32LE_MUXER) += $(FATE_HEADPHONE)
+$(FATE_HEADPHONE): tests/data/asynth-44100-2.wav tests/data/headphone-time.f32
+$(FATE_HEADPHONE): CMD = ffmpeg -filter_complex_threads $(@:fate-filter-headphone-freq-%=%) $(call HEADPHONE_ARGS,freq) -
+$(FATE_HEADPHONE): CMP = stddev
+$(FATE_HEADPHONE): CMP_UNIT = f32
+$(FATE_HEADPHONE): FUZZ = 6
+$(FATE_HEADPHONE): REF = tests/data/headphone-time.f32
+
 FATE_AFILTER-$(call FILTERDEMDECENCMUX, PAN, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-pan-mono1
 fate-filter-pan-mono1: tests/data/asynth-44100-2.wav
 fate-filter-pan-mono1: SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
@@ -62,6 +62,11 @@ fate-filter-paletteuse-bayer: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mk
 FATE_FILTER_PALETTEUSE += fate-filter-paletteuse-sierra2_4a
 fate-filter-paletteuse-sierra2_4a: CMD = framecrc -i $(TARGET_SAMPLES)/filter/anim.mkv -i $(TARGET_SAMPLES)/filter/anim-palette.png -lavfi paletteuse=sierra2_4a:diff_mode=rectangle -pix_fmt bgra
 
+# the threaded error diffusion must match the single threaded output
+FATE_FILTER_PALETTEUSE += fate-filter-paletteuse-sierra2_4a-threads
+fate-filter-paletteuse-sierra2_4a-threads: CMD = framecrc -filter_complex_threads 4 -i $(TARGET_SAMPLES)/filter/anim.mkv -i $(TARGET_SAMPLES)/filter/anim-palette.png -lavfi paletteuse=sierra2_4a:diff_mode=rectangle -pix_fmt bgra
+fate-filter-paletteuse-sierra2_4a-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-paletteuse-sierra2_4a
+
 fate-filter-paletteuse: $(FATE_FILTER_PALETTEUSE)
 FATE_FILTER_SAMPLES-$(call ALLYES, PALETTEUSE_FILTER MATROSKA_DEMUXER H264_DECODER IMAGE2_DEMUXER PNG_DECODER) += $(FATE_FILTER_PALETTEUSE)
 
@@ -122,6 +127,106 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER FORMAT_FILTER) += fa
 fate-filter-framerate-12bit-up: CMD = framecrc -lavfi testsrc2=r=50:d=1,format=pix_fmts=yuv422p12le,framerate=fps=60 -t 1 -pix_fmt yuv422p12le
 fate-filter-framerate-12bit-down: CMD = framecrc -lavfi testsrc2=r=60:d=1,format=pix_fmts=yuv422p12le,framerate=fps=50 -t 1 -pix_fmt yuv422p12le
 
+TONEMAP_INPUT = -f rawvideo -pix_fmt gbrpf32le -s 64x48 -color_trc linear -colorspace bt709 -i $(TARGET_PATH)/tests/data/tonemap.f32
+
+tests/data/tonemap.f32: TAG = GEN
+tests/data/tonemap.f32: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin \
+        -f lavfi -i "aevalsrc=12*pow(abs(sin(n*0.0123)*cos(n*0.00077))\,2):s=48000,atrim=end_sample=18432" \
+        -f f32le -y $(TARGET_PATH)/$@ 2>/dev/null
+
+tests/data/tonemap-%.raw: TAG = GEN
+tests/data/tonemap-%.raw: ffmpeg$(PROGSSUF)$(EXESUF) tests/data/tonemap.f32 | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin $(TONEMAP_INPUT) \
+        -vf tonemap=$*:peak=10 -f rawvideo -y $(TARGET_PATH)/$@ 2>/dev/null
+
+TONEMAP_DEPS = LAVFI_INDEV AEVALSRC_FILTER ATRIM_FILTER PCM_F32LE_ENCODER PCM_F32LE_MUXER RAWVIDEO_DEMUXER RAWVIDEO_DECODER TONEMAP_FILTER RAWVIDEO_ENCODER RAWVIDEO_MUXER
+
+# the exact tone curves
+FATE_TONEMAP_EXACT = fate-filter-tonemap-linear fate-filter-tonemap-gamma fate-filter-tonemap-clip \
+                     fate-filter-tonemap-reinhard fate-filter-tonemap-hable fate-filter-tonemap-mobius
+FATE_FILTER-$(call ALLYES, $(TONEMAP_DEPS) FRAMECRC_MUXER) += $(FATE_TONEMAP_EXACT)
+$(FATE_TONEMAP_EXACT): tests/data/tonemap.f32
+$(FATE_TONEMAP_EXACT): CMD = framecrc $(TONEMAP_INPUT) -vf tonemap=$(@:fate-filter-tonemap-%=%):peak=10
+
+# compare the lookup table tone curve against the exact one, clip ignores the table
+FATE_TONEMAP = fate-filter-tonemap-lut-gamma fate-filter-tonemap-lut-clip fate-filter-tonemap-lut-reinhard \
+               fate-filter-tonemap-lut-hable fate-filter-tonemap-lut-mobius
+FATE_FILTER-$(call ALLYES, $(TONEMAP_DEPS)) += $(FATE_TONEMAP)
+$(FATE_TONEMAP): fate-filter-tonemap-lut-%: tests/data/tonemap-%.raw
+$(FATE_TONEMAP): CMD = ffmpeg $(TONEMAP_INPUT) -vf tonemap=$(@:fate-filter-tonemap-lut-%=%):peak=10:lut=1 -f rawvideo -
+$(FATE_TONEMAP): CMP = stddev
+$(FATE_TONEMAP): CMP_UNIT = f32
+$(FATE_TONEMAP): FUZZ = 8
+$(FATE_TONEMAP): REF = tests/data/$(@:fate-filter-tonemap-lut-%=tonemap-%).raw
+
+# the cached text raster blended with slice threads must match the single
+# threaded output, the font size steps so that the raster is both reused and
+# rebuilt, the reference is generated as the glyphs depend on the font
+DRAWTEXT_FONT ?= $(firstword $(wildcard /usr/share/fonts/truetype/dejavu/DejaVuSans.ttf \
+                                        /usr/share/fonts/truetype/DejaVuSans.ttf \
+                                        /usr/share/fonts/TTF/DejaVuSans.ttf))
+DRAWTEXT_COLOR_opaque      = yellow
+DRAWTEXT_COLOR_translucent = yellow@0.5
+DRAWTEXT_ARGS = -f lavfi -i testsrc2=s=176x144:r=10:d=2 \
+        -vf "drawtext=fontfile=$(DRAWTEXT_FONT):text=FFmpeg:fontsize=32+trunc(n/8)*4:x=8:y=40:fontcolor=$(DRAWTEXT_COLOR_$(1)):borderw=2:bordercolor=black:shadowx=3:shadowy=4:shadowcolor=blue"
+
+tests/data/drawtext-%.raw: TAG = GEN
+tests/data/drawtext-%.raw: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -filter_threads 1 $(call DRAWTEXT_ARGS,$*) \
+        -f rawvideo -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_DRAWTEXT = fate-filter-drawtext-threads-opaque fate-filter-drawtext-threads-translucent
+FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER DRAWTEXT_FILTER RAWVIDEO_ENCODER RAWVIDEO_MUXER) += $(if $(DRAWTEXT_FONT),$(FATE_DRAWTEXT))
+$(FATE_DRAWTEXT): fate-filter-drawtext-threads-%: tests/data/drawtext-%.raw
+$(FATE_DRAWTEXT): CMD = ffmpeg -filter_threads 4 $(call DRAWTEXT_ARGS,$(@:fate-filter-drawtext-threads-%=%)) -f rawvideo -
+$(FATE_DRAWTEXT): CMP = oneoff
+$(FATE_DRAWTEXT): CMP_UNIT = 1
+$(FATE_DRAWTEXT): FUZZ = 1
+$(FATE_DRAWTEXT): REF = tests/data/$(@:fate-filter-drawtext-threads-%=drawtext-%).raw
+
+# the threaded motion estimation and compensation must match the single
+# threaded output
+MINTERPOLATE_VF_epzs = minterpolate=fps=20:me=epzs:mc_mode=aobmc
+MINTERPOLATE_VF_umh  = minterpolate=fps=20:me=umh:mc_mode=aobmc:vsbmc=1
+MINTERPOLATE_ARGS = -f lavfi -i testsrc2=s=176x144:r=10:d=1 -vf $(MINTERPOLATE_VF_$(1))
+
+tests/data/minterpolate-%.raw: TAG = GEN
+tests/data/minterpolate-%.raw: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -filter_threads 1 $(call MINTERPOLATE_ARGS,$*) \
+        -f rawvideo -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_MINTERPOLATE = fate-filter-minterpolate-threads-epzs fate-filter-minterpolate-threads-umh
+FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER MINTERPOLATE_FILTER RAWVIDEO_ENCODER RAWVIDEO_MUXER) += $(FATE_MINTERPOLATE)
+$(FATE_MINTERPOLATE): fate-filter-minterpolate-threads-%: tests/data/minterpolate-%.raw
+$(FATE_MINTERPOLATE): CMD = ffmpeg -filter_threads 3 $(call MINTERPOLATE_ARGS,$(@:fate-filter-minterpolate-threads-%=%)) -f rawvideo -
+$(FATE_MINTERPOLATE): CMP = oneoff
+$(FATE_MINTERPOLATE): CMP_UNIT = 1
+$(FATE_MINTERPOLATE): FUZZ = 1
+$(FATE_MINTERPOLATE): REF = tests/data/$(@:fate-filter-minterpolate-threads-%=minterpolate-%).raw
+
+# zscale split into slices must match the single threaded output
+ZSCALE_VF_resize     = zscale=w=352:h=288:f=spline36
+ZSCALE_VF_colorspace = zscale=min=170m:m=709
+ZSCALE_VF_dither     = format=yuv420p10le,zscale=min=170m:m=709:d=error_diffusion,format=yuv420p
+ZSCALE_ARGS = -f lavfi -i testsrc2=s=176x144:r=10:d=1 -vf $(ZSCALE_VF_$(1))
+
+tests/data/zscale-%.raw: TAG = GEN
+tests/data/zscale-%.raw: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
+	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< -nostdin -filter_threads 1 $(call ZSCALE_ARGS,$*) \
+        -f rawvideo -y $(TARGET_PATH)/$@ 2>/dev/null
+
+FATE_ZSCALE = fate-filter-zscale-threads-resize fate-filter-zscale-threads-colorspace fate-filter-zscale-threads-dither
+FATE_FILTER-$(call ALLYES, LAVFI_INDEV TESTSRC2_FILTER FORMAT_FILTER ZSCALE_FILTER RAWVIDEO_ENCODER RAWVIDEO_MUXER) += $(FATE_ZSCALE)
+$(FATE_ZSCALE): fate-filter-zscale-threads-%: tests/data/zscale-%.raw
+$(FATE_ZSCALE): CMD = ffmpeg -filter_threads 4 $(call ZSCALE_ARGS,$(@:fate-filter-zscale-threads-%=%)) -f rawvideo -
+$(FATE_ZSCALE): CMP = oneoff
+$(FATE_ZSCALE): CMP_UNIT = 1
+$(FATE_ZSCALE): FUZZ = 1
+# the resampling phase of each slice is derived from its active region
+fate-filter-zscale-threads-resize: FUZZ = 2
+$(FATE_ZSCALE): REF = tests/data/$(@:fate-filter-zscale-threads-%=zscale-%).raw
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 
@@ -754,6 +859,10 @@ FREEZEDETECT_DEPS = FFPROBE AVDEVICE LAVFI_INDEV MPTESTSRC_FILTER SCALE_FILTER F
 FATE_METADATA_FILTER-$(call ALLYES, $(FREEZEDETECT_DEPS)) += fate-filter-metadata-freezedetect
 fate-filter-metadata-freezedetect: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;mptestsrc=r=25:d=10:m=51,freezedetect"
 
+FRAMESTATS_DEPS = FFPROBE AVDEVICE LAVFI_INDEV TESTSRC2_FILTER FADE_FILTER PAD_FILTER SCALE_FILTER FRAMESTATS_FILTER
+FATE_METADATA_FILTER-$(call ALLYES, $(FRAMESTATS_DEPS)) += fate-filter-metadata-framestats
+fate-filter-metadata-framestats: CMD = run $(FILTER_METADATA_COMMAND) "sws_flags=+accurate_rnd+bitexact;testsrc2=s=320x240:r=25:d=2,fade=out:st=1:d=1,pad=400:300:40:30,framestats"
+
 SILENCEDETECT_DEPS = FFPROBE AVDEVICE LAVFI_INDEV AMOVIE_FILTER TTA_DEMUXER TTA_DECODER SILENCEDETECT_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(SILENCEDETECT_DEPS)) += fate-filter-metadata-silencedetect
 fate-filter-metadata-silencedetect: SRC = $(TARGET_SAMPLES)/lossless-audio/inside.tta
@@ -764,6 +873,10 @@ FATE_METADATA_FILTER-$(call ALLYES, $(EBUR128_METADATA_DEPS)) += fate-filter-met
 fate-filter-metadata-ebur128: SRC = $(TARGET_SAMPLES)/filter/seq-3341-7_seq-3342-5-24bit.flac
 fate-filter-metadata-ebur128: CMD = run $(FILTER_METADATA_COMMAND) "amovie='$(SRC)',ebur128=metadata=1"
 
+EBUR128_TRUEPEAK_DEPS = FFPROBE AVDEVICE LAVFI_INDEV AEVALSRC_FILTER EBUR128_FILTER
+FATE_METADATA_FILTER-$(call ALLYES, $(EBUR128_TRUEPEAK_DEPS)) += fate-filter-metadata-ebur128-truepeak
+fate-filter-metadata-ebur128-truepeak: CMD = run $(FILTER_METADATA_COMMAND) "aevalsrc=0.5*sin(2*PI*11000*t+PI/4)|0.5*sin(2*PI*997*t):s=48000:n=4800:d=1,ebur128=metadata=1:peak=true"
+
 READVITC_METADATA_DEPS = FFPROBE LAVFI_INDEV MOVIE_FILTER AVCODEC AVDEVICE \
                          AVI_DEMUXER FFVHUFF_DECODER READVITC_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(READVITC_METADATA_DEPS)) += fate-filter-metadata-readvitc-def
@@ -1094,5 +1094,13 @@ fate-swr-audioconvert: CMP = stddev
 fate-swr-audioconvert: FUZZ = 0
 
 FATE_SWR += $(FATE_SWR_AUDIOCONVERT-yes)
+
+# threaded output must match the single threaded one
+FATE_SWR_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_S16LE, PCM_S16LE) += fate-swr-threads-1 fate-swr-threads-3
+$(FATE_SWR_THREADS-yes): tests/data/asynth-44100-8.wav
+$(FATE_SWR_THREADS-yes): CMD = md5 -i $(TARGET_PATH)/tests/data/asynth-44100-8.wav -af aresample=48000:internal_sample_fmt=s32p:out_channel_layout=5.1:dither_method=triangular:threads=$(@:fate-swr-threads-%=%) -f s16le
+$(FATE_SWR_THREADS-yes): REF = $(SRC_PATH)/tests/ref/fate/swr-threads
+
+FATE_SWR += $(FATE_SWR_THREADS-yes)
 FATE_FFMPEG += $(FATE_SWR)
 fate-swr: $(FATE_SWR)
@@ -80,6 +80,23 @@ fate-vc1test_smm0015: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SMM0015.rcv
 FATE_VC1-$(CONFIG_MOV_DEMUXER) += fate-vc1-ism
 fate-vc1-ism: CMD = framecrc -i $(TARGET_SAMPLES)/isom/vc1-wmapro.ism -an
 
+# frame threaded decoding must match the single threaded output
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa00050-frame-threads
+fate-vc1_sa00050-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA00050.vc1
+fate-vc1_sa00050-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/vc1_sa00050
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1_DEMUXER) += fate-vc1_sa10143-frame-threads
+fate-vc1_sa10143-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SA10143.vc1
+fate-vc1_sa10143-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/vc1_sa10143
+
+FATE_VC1_FRAME_THREADS-$(CONFIG_VC1T_DEMUXER) += fate-vc1test_smm0005-frame-threads
+fate-vc1test_smm0005-frame-threads: CMD = framecrc -i $(TARGET_SAMPLES)/vc1/SMM0005.rcv
+fate-vc1test_smm0005-frame-threads: REF = $(SRC_PATH)/tests/ref/fate/vc1test_smm0005
+
+$(FATE_VC1_FRAME_THREADS-yes): THREADS = 2
+$(FATE_VC1_FRAME_THREADS-yes): THREAD_TYPE = frame
+FATE_VC1-yes += $(FATE_VC1_FRAME_THREADS-yes)
+
 FATE_MICROSOFT-$(CONFIG_VC1_DECODER) += $(FATE_VC1-yes)
 fate-vc1: $(FATE_VC1-yes)
 
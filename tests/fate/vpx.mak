@@ -159,6 +159,12 @@ $(eval $(call FATE_VP9_SUITE,trac4359))
 endef
 
 $(eval $(call FATE_VP9_FULL))
+
+# tile columns decoded in parallel inside the frame threads
+$(eval $(call FATE_VP9_SUITE,tiling-pedestrian,-tile-threads,-tile_threads 4))
+fate-vp9-tile-threads-tiling-pedestrian: THREADS = 2
+fate-vp9-tile-threads-tiling-pedestrian: THREAD_TYPE = frame+slice
+
 FATE_VP9-$(CONFIG_IVF_DEMUXER) += fate-vp9-05-resize
 fate-vp9-05-resize: CMD = framemd5 -i $(TARGET_SAMPLES)/vp9-test-vectors/vp90-2-05-resize.ivf -s 352x288 -sws_flags bitexact+bilinear
 fate-vp9-05-resize: REF = $(SRC_PATH)/tests/ref/fate/vp9-05-resize